@@ -7,27 +7,58 @@
 * A semântica das mensagens é específica para a aplicação IFSPresente.
 * Há nove tipos de mensagens emitidas pela TV-Box.
 * * <100|0|0>                        &rarr;  PING                                             
+* * <101|PAGINA|0>                   &rarr;  STATS (Tempos de resposta por código, com LATENCY_STATS; PAGINA R zera)
+* * <102|PAGINA|0>                   &rarr;  HEALTH (Contadores da serial, ritmo do loop, pilha, SRAM livre e I2C)
 * * <200|TEXTO|TIMEOUT>              &rarr;  TIME (Linha 0, para sala, data e hora)           
 * * <300|TEXTO|TIMEOUT>              &rarr;  LECTURE_NAME (Linha 1, para nome da palestra)    
 * * <400|TEXTO|TIMEOUT>              &rarr;  SPEAKER (Linha 2, para nome do palestrante)      
 * * <500|TEXTO|TIEMOUT>              &rarr;  ATTENDEE (Linha 3, aponta participante registrado
+* * <210|LINHA␟TIMEOUT␟TEXTO␞...|0>  &rarr;  SCREEN (Várias linhas num só quadro, trocadas juntas; ␟ é 0x1F e ␞ é 0x1E)
 * * <600|0|0>                        &rarr;  SUCCESS (Beep de sucesso no registro)            
 * * <601|0|0>                        &rarr;  FAIL (Beep de falha no registro)
+* * <602|POS:FREQ:DUR:PAUSA[:FREQ:DUR:PAUSA...]|0> &rarr; BEEP_PATTERN (Grava um padrão de bipes na posição POS; tempos em ms, FREQ 0 é silêncio)
+* * <603|POS|0>                      &rarr;  BEEP_PLAY (Toca o padrão gravado na posição POS)
 * * <700|YYYY:MM:DD:HH:MM:SS|0>      &rarr;  SETTIME (Define a hora do RTC)
 * * <701|0|0>                        &rarr;  GETTIME (Recebe a hora do RTC, além da temperatura)     
+* * <800|TAXA|TIMEOUT>               &rarr;  SETBAUD (Troca a taxa da serial; volta a 9600 se não chegar quadro válido em TIMEOUT ms)
+* * <801|MODO|0>                      &rarr;  FRAMING (0: texto, o padrão; 1: binário compacto, ver SerialProtocol::parseBinary())
+* * <802|MODO|0>                      &rarr;  CHECKSUM (1: quadros de texto passam a <code|msg|TTL|SEQ|CRC>, ver SerialProtocol::checksumMode)
+* * <803|MODO|0>                      &rarr;  ENCODING (0: texto em Windows-1252, o padrão; 1: UTF-8, ver SerialProtocol::utf8Mode)
+* * <900|LINHA:PASSO:PAUSA_INICIO:PAUSA_FIM:MODO|0> &rarr; SCROLL (Rolagem da linha, tempos em ms; MODO: 0 volta ao início, 1 vai e volta, 2 letreiro circular, +4 suavizado)
 *
-* O Arduino responde com três tipos de mensagens.
+* No modo binário os mesmos comandos e respostas são codificados como `opcode | varint | tamanho | texto | CRC-16`:
+* o varint leva o TTL (comandos), o uptime (001), a temperatura em centésimos de kelvin (003) ou a taxa (004).
+*
+* O Arduino responde com oito tipos de mensagens.
 * * <001|uptime em milissegundos|versão de firmware>  &rarr; Resposta ao ping 
 * * <003|YYYY:MM:DD:HH:MM:SS|temperatura>             &rarr; Resposta ao gettime                     
 * * <002|OK|>                                         &rarr; Resposta aos demais comandos 
+* * <004|taxa|>                                       &rarr; Resposta ao setbaud, com a taxa que passa a valer
+* * <005|SEQ|>                                        &rarr; NAK: quadro corrompido, a TV-Box deve repetir o quadro SEQ
+* * <006|PAGINA|dados>                                &rarr; Resposta ao stats (ver LatencyStats::format()); dados vazios depois da última página
+* * <007|PAGINA|dados>                                &rarr; Resposta ao health (ver formataSaude()); dados vazios depois da última página
+* * <008|CODIGO|>                                     &rarr; Comando CODIGO recusado (campos inválidos), nada foi alterado
 *                 
 * Outras aplicações podem definir outros modelos de mensagens nos quadros do protocolo.
 */
 
 #include <Wire.h>              // Biblioteca utilizada para fazer a comunicação com o I2C
+#ifdef LCD_LIQUIDCRYSTAL_I2C
 #include <LiquidCrystal_I2C.h> // Biblioteca utilizada para fazer a comunicação com o display 20x4 
+#endif
 #include <RTClib.h>            // Biblioteca utilizada para ajuste e leitura de 
 #include "frame.h"             // Implementação da classe SerialProtocol
+#include "display.h"           // Geometria do display, estado das linhas e a tela em RAM
+#include "hd44780.h"           // Driver do LCD, nos pinos (opção LCD_PARALLEL em config.h) ou no I2C
+#include "i2cbus.h"            // Relógio e contadores do barramento I2C
+#include "glyphs.h"            // Letras acentuadas na CGRAM do LCD (opção LCD_ACCENTS em config.h)
+#include "uart.h"              // Driver próprio da USART0 (opção USE_NATIVE_UART em config.h)
+#include "bench.h"             // Medições de vazão do protocolo (opção BENCHMARK em config.h)
+#include "scheduler.h"         // Escalonador cooperativo das tarefas do loop()
+#include "buzzer.h"            // Sequências de bipes tocadas em segundo plano
+#include "latency.h"           // Tempos de resposta por comando (opção LATENCY_STATS em config.h)
+#include "health.h"            // Ritmo do loop(), pilha e SRAM livre
+#include "rtcclock.h"          // Data, hora e temperatura do DS3231 mantidas em RAM pelo pulso do SQW
 
 /** 
  * @name Códigos de Mensagens do Protocolo.
@@ -37,14 +68,24 @@
 * @{
 */
 #define PING         100 /**< Obtém o timestamp do uptime e a versão do firmware. */ 
+#define STATS        101 /**< Obtém uma página dos tempos de resposta por código de comando, ou os zera. */
+#define HEALTH       102 /**< Obtém uma página dos indicadores de saúde: erros da serial, ritmo do loop, pilha, SRAM e I2C. */
 #define TIME         200 /**< Linha 0: sala, data e hora. */
 #define LECTURE_NAME 300 /**< Linha 1: nome da palestra. */
 #define SPEAKER      400 /**< Linha 2: nome do professor responsável pela aula em curso. */
 #define ATTENDEE     500 /**< Linha 3: estudante que aponta sua presença. */
+#define SCREEN       210 /**< Várias linhas, cada uma com o seu TTL, trocadas juntas num só quadro. */
 #define SUCCESS      600 /**< Beep de sucesso no registro, seja por leitor biométrico de digital ou por senha no teclado numérico. */
 #define FAIL         601 /**< Beep de falha no registro, seja por leitor biométrico de digital ou por senha no teclado numérico. */
+#define BEEP_PATTERN 602 /**< Comando para gravar um padrão de bipes (frequência, duração e pausa de cada um). */
+#define BEEP_PLAY    603 /**< Comando para tocar um padrão de bipes gravado. */
 #define SETTIME      700 /**< Comando para ajustar data/hora do RTC ligado ao Arduino. */
 #define GETTIME      701 /**< Comando para solicitar data/hora do RTC ligado ao Arduino, além da temperatura. */
+#define SETBAUD      800 /**< Comando para trocar a taxa da serial (9600, 115200, 250000, 500000 ou 1000000 bauds). */
+#define FRAMING      801 /**< Comando para escolher o formato dos quadros da sessão: 0 texto, 1 binário compacto. */
+#define CHECKSUM     802 /**< Comando para ligar (1) ou desligar (0) o número de sequência e o CRC-16 nos quadros de texto. */
+#define ENCODING     803 /**< Comando para escolher a codificação do texto da sessão: 0 Windows-1252, 1 UTF-8. */
+#define SCROLL       900 /**< Comando para ajustar a rolagem de uma linha: passo, pausas e modo. */
 /** @} */
 
 
@@ -56,13 +97,16 @@
 * @{
 */
 #define BUZZER      2               /**< Pino digital ligado ao _buzzer_. */
-#define COL        20               /**< Serve para definir o numero de colunas do display utilizado. */ 
-#define ROW         4               /**< Serve para definir o numero de linhas do display utilizado.  */
 #define ADDRESS  0x27               /**< Serve para definir o endereço do display. */
-#define DISPLAY_UPDATE_DELAY 500    /**< Tempo em milissegundos em que um texto é exibido numa linha do display antes de sofrer _scroll_. */ 
-#define LOOP_DELAY            10    /**< Tempo em que o loop principal do código do Arduino dorme à espera de uma mensagem. */
-#define KEEP_AT_ZERO           1    /**< Quando um texto é exibido numa linha do display, deve ficar um tempo a mais antes de iniciar o _scroll_. */
-#define KEEP_AT_LAST           1    /**< Quando um texto é exibido numa linha do display, deve ficar um tempo a mais antes de reiniciar o _scroll_. */
+#define DISPLAY_UPDATE_DELAY 500    /**< Tempo padrão em milissegundos entre dois passos do _scroll_ de uma linha. */ 
+#define DISPLAY_IDLE_WAKEUP 60000UL /**< Maior intervalo entre duas verificações do display quando nenhuma linha rola nem expira. */
+#define SERIAL_POLL_PERIOD   100    /**< Maior intervalo em milissegundos entre duas passadas da recepção sem bytes chegando (prazo da troca de taxa). */
+#define I2C_RATES_PERIOD    1000    /**< Intervalo em milissegundos entre dois cálculos das taxas do I2C. */
+#define HEALTH_PERIOD       1000    /**< Intervalo em milissegundos entre dois cálculos do ritmo do loop(). */
+#define RTC_TEMPERATURE_PERIOD 64000UL /**< Intervalo em milissegundos entre duas leituras da temperatura, o mesmo das conversões do DS3231. */
+#define KEEP_AT_ZERO           1    /**< Quando um texto é exibido numa linha do display, deve ficar um tempo a mais antes de iniciar o _scroll_ (em passos, na configuração padrão). */
+#define KEEP_AT_LAST           1    /**< Quando um texto é exibido numa linha do display, deve ficar um tempo a mais antes de reiniciar o _scroll_ (em passos, na configuração padrão). */
+#define LCD_FLUSH_BUDGET       8    /**< Máximo de caracteres (e posicionamentos do cursor) enviados ao LCD por passada do loop. */
 /** @} */
 
 /**
@@ -74,7 +118,8 @@
 struct ProtocolMessage {
   int code;                     /**< Código do serviço solicitado. */
   int TTL;                      /**< Tempo de vida para mensagens que são exibidas no _display_. */
-  char message[MAX_STRING+1];   /**< Mensagem. */
+  char *message;                /**< Mensagem, dentro de `usbProto.receivedChars`; vale até o próximo quadro. */
+  byte messageSize;             /**< Tamanho da mensagem, no máximo `MAX_STRING`. */
 };
 
 /**
@@ -84,49 +129,40 @@ struct ProtocolMessage {
 ProtocolMessage netMessage;
 
 /**
- * @struct Display
- * @brief Representa o estado de uma linha do display LCD.
- *
- * Esta estrutura guarda a mensagem principal, a mensagem padrão, a parte da
- * mensagem que deve ser impressa no momento, além de informações de tamanho,
- * posição e tempo de vida (TTL).
+ * @typedef Display
+ * @brief Estado de uma linha do display LCD, com os tamanhos de `Geometry` (ver display.h).
  */
-struct Display {
-  char message[MAX_STRING + 1];        /**< Mensagem atual a ser exibida. */
-  char defaultMessage[MAX_STRING + 1]; /**< Mensagem padrão quando nenhuma outra estiver ativa. */
-  char toPrint[COL+1];                 /**< Parte da mensagem que é impressa no display num dado momento. */
-  int messageSize;                     /**< Tamanho da mensagem atual. */
-  int defaultMessageSize;              /**< Tamanho da mensagem padrão. */
-  int startPosition;                   /**< Posição inicial na mensagem a partir da qual imprime-se no display. */
-  byte keepAtZeroPosition;             /**< Quando o trecho inicial da mensagem está sendo impresso, permanece por um tempo maior nesse estado. */
-  unsigned long TTL;                    /**< Tempo de vida da mensagem em milissegundos. Após esse período, retorna à mensagem _default_. */
-};
+typedef Geometry::Line Display;
 
 /**
- * @var Display dispArray[ROW]
- * @brief Informações para as quatro linhas do Display.
+ * @var Display dispArray[Geometry::ROWS]
+ * @brief Informações para as linhas do Display.
  *
- * Contém as quatro linhas do display LCD. Cada posição tem:
+ * Contém uma posição por linha do display LCD. Cada posição tem:
  * - Mensagem atual (`message`)
  * - Mensagem padrão (`defaultMessage`)
- * - Texto a imprimir (`toPrint`)
  * - Tamanho da mensagem (ajustado em `setup()`)
  * - Tamanho da mensagem padrão (ajustado em `setup()`)
  * - Posição inicial da string a partir da onde imprime no display
  * - Tempo de vida (TTL) de impressão da mensagem
  *
- * Inicialmente preenchido com mensagens padrão do sistema:
+ * As mensagens padrão vêm de `defaultMessages` no `setup()`.
+ */
+Display dispArray[Geometry::ROWS];
+
+/**
+ * @var defaultMessages
+ * @brief Mensagens padrão do sistema, uma por linha (as que não couberem na tela ficam de fora).
  * - Linha 0 → "IFSPresente"
  * - Linha 1 → "Local Disponivel"
  * - Linha 2 → "Sem reserva de palestrante"
  * - Linha 3 → "Aguardando Registro"
  */
-Display dispArray[ROW] = {
-                          {"", "IFSPresente", "", 0, 0, 0, KEEP_AT_ZERO, 0},
-                          {"", "Local Disponivel", "", 0, 0, 0, KEEP_AT_ZERO, 0},
-                          {"", "Sem reserva de palestrante", "", 0, 0, 0, KEEP_AT_ZERO, 0},
-                          {"", "Aguardando Registro", "", 0, 0, 0, KEEP_AT_ZERO, 0}
-                         };
+const char defaultMessage0[] PROGMEM = "IFSPresente";
+const char defaultMessage1[] PROGMEM = "Local Disponivel";
+const char defaultMessage2[] PROGMEM = "Sem reserva de palestrante";
+const char defaultMessage3[] PROGMEM = "Aguardando Registro";
+const char * const defaultMessages[] PROGMEM = {defaultMessage0, defaultMessage1, defaultMessage2, defaultMessage3};
 
 /**
  * @var char* VERSION
@@ -146,168 +182,473 @@ char auxStr[MAX_STRING + 1];
 unsigned long uptime;
 
 RTC_DS3231 rtc;  //Objeto rtc da classe DS3231
-LiquidCrystal_I2C lcd(ADDRESS,COL,ROW); // Chamada da funcação LiquidCrystal para ser usada com o I2C
+#if defined(LCD_PARALLEL)
+Hd44780Parallel lcd(Geometry::COLS,Geometry::ROWS);          // LCD nos pinos do Arduino, sem o módulo I2C
+#elif defined(LCD_LIQUIDCRYSTAL_I2C)
+LiquidCrystal_I2C lcd(ADDRESS,Geometry::COLS,Geometry::ROWS); // Chamada da funcação LiquidCrystal para ser usada com o I2C
+#else
+Hd44780I2c lcd(Geometry::COLS,Geometry::ROWS,Hd44780BusI2c(ADDRESS)); // Módulo I2C, com as escritas agrupadas em poucas transações
+#endif
 
-DateTime now;
+/**
+ * @var LcdFrameBuffer lcdBuffer
+ * @brief Tela em RAM; o `loop()` a envia ao LCD em fatias de `LCD_FLUSH_BUDGET`.
+ */
+Geometry::FrameBuffer lcdBuffer;
+
+#ifdef LCD_ACCENTS
+/**
+ * @var GlyphCache glyphs
+ * @brief Letras acentuadas desenhadas na CGRAM; converte o texto de `lcdBuffer` na escrita.
+ */
+GlyphCache glyphs;
+#endif
+
+/**
+ * @var Buzzer buzzer
+ * @brief Padrões de bipes do _buzzer_, tocados pela tarefa `TASK_BUZZER`.
+ */
+Buzzer buzzer(BUZZER);
 
 
 /**
  * @var SerialProtocol usbProto
  * @brief Classe que implementa a transmissão e recepção de quadros pela serial sobre USB.
  */
+#ifdef USE_NATIVE_UART
+SerialProtocol usbProto(uart);
+#else
 SerialProtocol usbProto;
+#endif
 
+/**
+ * @enum TaskId
+ * @brief Tarefas do `loop()`, na ordem de prioridade (ver `taskTable`).
+ */
+enum TaskId {
+  TASK_SERIAL,   /**< Recebe e trata os quadros da TV-Box (`trataQuadros()`). */
+  TASK_BUZZER,   /**< Próximo bipe do padrão que está tocando (`tocaBuzzer()`). */
+  TASK_DISPLAY,  /**< Passos da rolagem e fim dos TTL (`atualizaDisplay()`). */
+  TASK_LCD,      /**< Envia ao LCD uma fatia do que mudou em `lcdBuffer` (`enviaLcd()`). */
+  TASK_I2C,      /**< Taxas do barramento I2C (`i2c.updateRates()`). */
+  TASK_RTC,      /**< Alinha a hora com o pulso do SQW e lê a temperatura (`rtcClock.refresh()`). */
+  TASK_HEALTH,   /**< Passadas do loop() por segundo (`health.updateRate()`). */
+  NUM_TASKS
+};
+
+void trataQuadros();
+void tocaBuzzer();
+void tarefaDisplay();
+void enviaLcd();
+void tarefaI2c();
+void tarefaRelogio();
+void tarefaSaude();
 
 /**
- * @brief Copia um trecho de uma string de origem para um buffer de destino,
- *        ajustando posição inicial e preenchendo com espaços em branco, se necessário.
- *
- * Esta função garante que o conteúdo copiado caiba exatamente no tamanho
- * do display (ou outro destino), ajustando o índice inicial (`start`) caso:
- * - A string de origem seja menor ou igual ao destino → começa da posição zero.
- * - A string de origem seja maior que o destino, mas o ponto inicial da cópia desejada ultrapasse os limites → recua
- *   o início para preencher completamente o destino.
- *
- * Após a cópia, o restante do buffer de destino é preenchido com espaços em branco,
- * e o finalizador `'\0'` é adicionado ao fim.
- *
- * @param[out] dest       Buffer de destino (receberá a string copiada).
- * @param[in]  sizeDest   Tamanho da string que ficará em `dest`, número de caracteres visíveis no display. O buffer `dest` precisa ter pelo menos (sizeDest+1) bytes.
- * @param[in]  origem     String de origem.
- * @param[in]  sizeOrigem Tamanho da string de origem.
- * @param[in]  start      Posição inicial na string de origem a partir da qual
- *                        a cópia deve começar (pode ser ajustada internamente pelo algoritmo).
- *
- * @note Usa `min(sizeDest, sizeOrigem)` para calcular o máximo de caracteres a copiar.
- *       O destino é sempre terminado em `'\0'`.
- *
- *
- * @section img_sec2 Exemplo de Funcionamento
- * \image html img/copiaParcialDeString.png "Detalhamento do Algoritmo"
+ * @var taskTable
+ * @brief Função de cada tarefa, indexada por `TaskId`.
  */
-/*****************************************************************************/
-/*                                                                           */
-/*****************************************************************************/
-void copiaN(char dest[], int sizeDest, char origem[], int sizeOrigem, int start ) {
-
-     //Se a string cabe no display, não pode iniciar impressão para além da posição zero
-     if (sizeDest >= sizeOrigem) 
-         start = 0;
-     else {
-         //E se for maior que o display, se mandar copiar de uma string grande uma parte final inferior ao tamanho do display
-         //Recua ao ponto de cópia que preenche completamente o display
-         if (start > sizeOrigem - sizeDest)
-            start = sizeOrigem-sizeDest;
-     }
-
-     //Quantidade máxima de caracteres copiados da origem
-     int maxToCopy = min(sizeDest, sizeOrigem);
-     for (int i = 0; i < maxToCopy; i++) {
-      dest[i] = origem[i+start];
-     }
-     //Preenche o final com espaços em branco, se necessário
-     for (int i = maxToCopy; i < sizeDest; i++) {
-        dest[i] = ' ';
-     }
-     //Põe o finalizador
-     dest[sizeDest] = '\0';    
-}
+const Scheduler<NUM_TASKS>::Task taskTable[NUM_TASKS] PROGMEM = {trataQuadros, tocaBuzzer, tarefaDisplay, enviaLcd, tarefaI2c, tarefaRelogio, tarefaSaude};
+
+/**
+ * @var Scheduler tasks
+ * @brief Escalonador das tarefas; cada uma é acordada por um evento ou pelo seu prazo.
+ */
+Scheduler<NUM_TASKS> tasks(taskTable);
+
 
 /**
  * @brief Atualiza o conteúdo exibido no display LCD linha a linha.
  *
  * Esta função gerencia a exibição de mensagens no display, considerando:
- * - **Tempo mínimo entre atualizações** (usando `millis()` e `DISPLAY_UPDATE_DELAY`).
  * - **Mensagens temporárias (TTL)**: quando expiram, voltam para a mensagem padrão.
- * - **Rolagem horizontal (scroll)**: caso a mensagem seja maior que o número de colunas (`COL`),
- *   realiza deslocamento progressivo, mantendo o início por alguns ciclos
- *   (`KEEP_AT_ZERO`) antes de avançar.
+ * - **Rolagem horizontal (scroll)**: caso a mensagem seja maior que o número de colunas (`Geometry::COLS`),
+ *   realiza deslocamento progressivo, com velocidade, pausas e modo próprios de cada linha
+ *   (ver `DisplayLine::advance()` e o comando `SCROLL`).
  *
  * O comportamento difere conforme a mensagem ativa:
  * - Se `dispArray[i].TTL` expirou → mostra `defaultMessage` com rolagem.
  * - Caso contrário → mostra `message` com rolagem.
  *
  * @param[in] lines Índice da linha a ser atualizada:
- *                  - `-1` → atualiza todas as linhas, para efeito de rolagem horizontal, então faz a cada DISPLAY_UPDATE_DELAY milissegundos.
- *                  - `0..ROW-1` → atualiza apenas a linha especificada e faz automaticamente independentemente de DISPLAY_UPDATE_DELAY ter expirado, alcançando boa responsividade.
+ *                  - `-1` → atualiza as linhas cuja rolagem ou TTL venceu; retorna de imediato se nenhuma venceu.
+ *                  - `0..Geometry::ROWS-1` → atualiza apenas a linha especificada, imediatamente, alcançando boa responsividade.
  *
  * @note
- * - Usa `copiaN()` para preencher o buffer de exibição (`toPrint`).
- * - Usa o estado da máquina (`usbProto.machState`) para evitar atualizações
- *   durante recepção de dados.
- * - O cursor do LCD é posicionado no início de cada linha (`lcd.setCursor(0,i)`).
- *
- * ### Regras de rolagem
- * - Quando `startPosition == 0`, mantém a mensagem parada por `KEEP_AT_ZERO` ciclos.
- * - Depois, incrementa `startPosition` até o limite calculado,
- *   com espera em `KEEP_AT_LAST` no final.
+ * - Cada linha tem o seu instante do próximo passo (`nextMove`). A função
+ *   guarda o mais próximo desses instantes e dos vencimentos de TTL como
+ *   prazo de `TASK_DISPLAY`, e só trabalha quando ele chega: linhas paradas
+ *   não acordam o display.
+ * - A linha só é escrita em `lcdBuffer`; o `loop()` envia ao LCD os trechos
+ *   que mudaram, aos poucos. Linhas paradas não geram tráfego no I2C.
  */
 /*****************************************************************************/
 /*                                                                           */
 /*****************************************************************************/
 void atualizaDisplay(int lines) {
-   static unsigned long nextUpdate = 0;
+   static unsigned long nextWakeup = 0;
    unsigned long currentTime = millis();
-   bool updateNext = false;
-  
-  if (currentTime < nextUpdate) {  //Avalia se o tempo de realizar update no display expirou
-      if (usbProto.machState != SerialProtocol::RECEIVED)
-          return;
-  }
 
-   if (usbProto.machState != SerialProtocol::RECEIVED)
-       nextUpdate = currentTime + DISPLAY_UPDATE_DELAY;
+   if (lines == -1) {
+       if ((long) (currentTime - nextWakeup) < 0) {  //Nenhuma linha precisa mudar ainda
+           tasks.at(TASK_DISPLAY, nextWakeup);
+           return;
+       }
+       nextWakeup = currentTime + DISPLAY_IDLE_WAKEUP;
+   }
 
-   for (int i = 0; i < ROW; i++) {
+   for (byte i = 0; i < Geometry::ROWS; i++) {
       if (lines != -1 && i != lines)
-          continue;   
-      if (dispArray[i].TTL < currentTime) {
-        copiaN(dispArray[i].toPrint, 
-               COL, 
-               dispArray[i].defaultMessage, 
-               dispArray[i].defaultMessageSize,
-               dispArray[i].startPosition);
-        if (dispArray[i].defaultMessageSize > COL) {
-            if (dispArray[i].startPosition == 0 && dispArray[i].keepAtZeroPosition > 0) {
-                dispArray[i].keepAtZeroPosition--;
-            }
-            else {
-                dispArray[i].startPosition = (dispArray[i].startPosition + 1) % (dispArray[i].defaultMessageSize - COL + 1 + KEEP_AT_LAST);
-                dispArray[i].keepAtZeroPosition = KEEP_AT_ZERO;
-            }
-        }
+          continue;
+      Display &d = dispArray[i];
+      bool expired = d.TTL < currentTime;
+      if (expired != d.showingDefault) {
+          d.showingDefault = expired;
+          d.restart();
       }
-      else {
-        copiaN(dispArray[i].toPrint, 
-               COL, 
-               dispArray[i].message, 
-               dispArray[i].messageSize,
-               dispArray[i].startPosition);
-        if (dispArray[i].messageSize > COL) {
-            if (dispArray[i].startPosition == 0 && dispArray[i].keepAtZeroPosition > 0) {
-                dispArray[i].keepAtZeroPosition--;
-            }
-            else {
-                dispArray[i].startPosition = (dispArray[i].startPosition + 1) % (dispArray[i].messageSize - COL + 1 + KEEP_AT_LAST);
-                dispArray[i].keepAtZeroPosition = KEEP_AT_ZERO;
-            }
-        }
 
+      bool changed = true;
+      if (d.redraw) {
+          d.redraw = false;
+          d.nextMove = currentTime + d.pauseStart;
       }
-      lcd.setCursor(0,i);
-      lcd.print(dispArray[i].toPrint);
+      else if (d.scrolls() && (long) (currentTime - d.nextMove) >= 0)
+          d.nextMove = currentTime + d.advance();
+      else
+          changed = false;
+
+      if (changed) {
+          d.render(lcdBuffer.edit(i));  //Direto na tela em RAM, sem buffer intermediário
+          lcdBuffer.touch(i);
+      }
+
+      //Agenda a próxima visita: próximo passo da rolagem ou fim do TTL
+      if (d.scrolls() && (long) (d.nextMove - nextWakeup) < 0)
+          nextWakeup = d.nextMove;
+      if (!d.showingDefault && (long) (d.TTL + 1 - nextWakeup) < 0)
+          nextWakeup = d.TTL + 1;
    }
+   tasks.at(TASK_DISPLAY, nextWakeup);
+}
+
+/**
+ * @brief Responde `002|OK|` no formato da sessão (texto ou binário).
+ */
+/*****************************************************************************/
+/*                                                                           */
+/*****************************************************************************/
+void respondeOK() {
+    if (usbProto.binaryMode)
+        usbProto.sendBinary(2, 0, "OK");
+    else
+        usbProto.sendFrame("002|OK|");
+}
+
+/**
+ * @brief Responde `008|CODIGO|` no formato da sessão: o comando foi recusado e nada mudou.
+ *
+ * @param code Código do comando recusado.
+ */
+/*****************************************************************************/
+/*                                                                           */
+/*****************************************************************************/
+void respondeRecusa(int code) {
+    if (usbProto.binaryMode) {
+        usbProto.sendBinary(8, code, "");
+        return;
+    }
+    strcpy(strReply, "008|");
+    utoa(code, strReply + 4, 10);
+    strcat(strReply, "|");
+    usbProto.sendFrame(strReply);
+}
+
+/**
+ * @brief Responde uma página de STATS ou HEALTH, `CODIGO|PAGINA|dados`, no formato da sessão.
+ *
+ * @param code Código da resposta (6 ou 7).
+ * @param page Página pedida.
+ * @param data Conteúdo da página; vazio se ela não existe.
+ */
+/*****************************************************************************/
+/*                                                                           */
+/*****************************************************************************/
+void respondePagina(int code, byte page, const char *data) {
+    if (usbProto.binaryMode) {
+        usbProto.sendBinary(code, page, data);
+        return;
+    }
+    strcpy(strReply, "00");
+    utoa(code, strReply + 2, 10);
+    strcat(strReply, "|");
+    utoa(page, strReply + strlen(strReply), 10);
+    strcat(strReply, "|");
+    strcat(strReply, data);
+    usbProto.sendFrame(strReply);
+}
+
+/**
+ * @brief Escreve uma página dos indicadores de saúde (comando HEALTH).
+ *
+ * Os campos são separados por ':':
+ * - página 0: `QUADROS_RECEBIDOS:QUADROS_ENVIADOS:BYTES_DESCARTADOS`;
+ * - página 1: `ERROS_DE_ESCAPE:QUADROS_GRANDES:FILA_CHEIA:ESTOUROS_RX`
+ *   (ver `SerialProtocol::Counters`);
+ * - página 2: `PASSADAS_POR_S:MAIOR_TAREFA_US:FOLGA_DA_PILHA:SRAM_LIVRE`,
+ *   os dois últimos em bytes;
+ * - página 3: `TRANSACOES_I2C_POR_S:BYTES_I2C_POR_S:ERROS_I2C:CARGAS_DA_CGRAM`
+ *   (ver `I2cBus` e `GlyphCache::uploads`; sem `LCD_ACCENTS` as cargas são 0).
+ *
+ * Os contadores são cumulativos desde o reset; quem monitora compara
+ * duas leituras. A maior tarefa (`tasks.longest`) é a passada mais longa
+ * do `loop()`. A folga da pilha é a menor já vista (`Health::stackHeadroom()`).
+ *
+ * @param page Página.
+ * @param out  Destino, com pelo menos 33 bytes.
+ * @return `false` se a página não existe (`out` fica vazio).
+ */
+/*****************************************************************************/
+/*                                                                           */
+/*****************************************************************************/
+bool formataSaude(byte page, char *out) {
+    SerialProtocol::Counters c;
+    unsigned long value[4];
+    byte n = 0;
+    out[0] = '\0';
+    switch (page) {
+      case 0:
+      case 1:
+        usbProto.snapshot(c);
+        if (page == 0) {
+            value[n++] = c.framesReceived;
+            value[n++] = c.framesSent;
+            value[n++] = c.discardedBytes;
+        }
+        else {
+            value[n++] = c.escapeErrors;
+            value[n++] = c.oversizeFrames;
+            value[n++] = c.droppedFrames;
+            value[n++] = c.rxOverruns;
+        }
+        break;
+      case 2:
+        value[n++] = health.loopsPerSecond;
+        value[n] = 0;
+        for (byte i = 0; i < NUM_TASKS; i++)
+            value[n] = max(value[n], tasks.longest[i]);
+        n++;
+        value[n++] = Health::stackHeadroom();
+        value[n++] = Health::freeRam();
+        break;
+      case 3:
+        value[n++] = i2c.transactionsPerSecond;
+        value[n++] = i2c.bytesPerSecond;
+        value[n++] = i2c.errors;
+#ifdef LCD_ACCENTS
+        value[n++] = glyphs.uploads;
+#else
+        value[n++] = 0;
+#endif
+        break;
+      default:
+        return false;
+    }
+    for (byte i = 0; i < n; i++) {
+        if (i > 0)
+            *out++ = ':';
+        ultoa(value[i], out, 10);
+        out += strlen(out);
+    }
+    return true;
+}
+
+/**
+ * @name Separadores do comando SCREEN.
+ * @brief Caracteres de controle do ASCII feitos para isso; não aparecem em texto.
+* @{
+*/
+#define RECORD_SEPARATOR 0x1E  /**< Separa as linhas (RS). */
+#define UNIT_SEPARATOR   0x1F  /**< Separa os campos de uma linha (US). */
+/** @} */
+
+/**
+ * @brief Lê um campo numérico decimal.
+ *
+ * Só dígitos: um campo vazio, com sinal ou espaços, ou acima de `max` é
+ * recusado, em vez de virar 0 ou dar a volta como com `strtoul()`.
+ *
+ * @param[in,out] p     Início do campo; para no primeiro caractere que não é dígito.
+ * @param         max   Maior valor aceito.
+ * @param[out]    value Valor lido.
+ * @return `false` se o campo não começa com um dígito ou passa de `max`.
+ */
+/*****************************************************************************/
+/*                                                                           */
+/*****************************************************************************/
+bool leNumero(char *&p, unsigned long max, unsigned long &value) {
+    if (*p < '0' || *p > '9')
+        return false;
+    value = 0;
+    for (; *p >= '0' && *p <= '9'; p++) {
+        byte digit = *p - '0';
+        if (value > max / 10)
+            return false;
+        value *= 10;
+        if (digit > max - value)
+            return false;
+        value += digit;
+    }
+    return true;
+}
+
+/**
+ * @brief Troca a mensagem de uma linha e recomeça a sua rolagem, sem redesenhá-la.
+ *
+ * Comum a TIME, LECTURE_NAME, SPEAKER, ATTENDEE e SCREEN.
+ *
+ * @param line Linha do display.
+ * @param text Mensagem, com no máximo `MAX_STRING` caracteres.
+ * @param size Tamanho da mensagem.
+ * @param ttl  Tempo de vida em milissegundos.
+ * @return `false` se a linha não existe no display; nada é alterado.
+ */
+/*****************************************************************************/
+/*                                                                           */
+/*****************************************************************************/
+bool defineLinha(byte line, const char *text, byte size, unsigned long ttl) {
+    if (line >= Geometry::ROWS)
+        return false;
+    Display &d = dispArray[line];
+    memcpy(d.message, text, size);
+    d.message[size] = '\0';
+    d.messageSize = size;
+    d.TTL = millis() + ttl;
+    d.restart();
+    return true;
+}
+
+/**
+ * @brief Aplica o comando SCREEN: várias linhas de uma vez.
+ *
+ * A mensagem traz um registro por linha, separados por `RECORD_SEPARATOR`,
+ * cada um com `LINHA`, `TIMEOUT` e `TEXTO` separados por `UNIT_SEPARATOR`.
+ * Linhas ausentes ficam como estão. Todos os registros são conferidos antes
+ * de qualquer linha mudar: um campo faltando ou que não é número, uma linha
+ * inexistente, um TIMEOUT acima de 32767 ms (o limite dos outros comandos)
+ * ou mais registros que linhas descartam o quadro inteiro. As linhas trocadas são
+ * redesenhadas juntas em `lcdBuffer`, que as envia ao LCD na mesma leva.
+ *
+ * Tudo precisa caber num quadro (`MAX_STRING` caracteres de mensagem); o
+ * que não couber vai num segundo SCREEN ou nos comandos de cada linha.
+ *
+ * @param records Mensagem do quadro; os separadores são trocados por `'\0'`.
+ * @return `false` se o quadro foi descartado.
+ */
+/*****************************************************************************/
+/*                                                                           */
+/*****************************************************************************/
+bool defineTela(char *records) {
+    byte line[Geometry::ROWS];
+    unsigned long ttl[Geometry::ROWS];
+    char *text[Geometry::ROWS];
+    byte count = 0;
+    char *p = records;
+    if (*p == '\0')
+        return false;
+    while (true) {
+        if (count == Geometry::ROWS)
+            return false;
+        unsigned long n;
+        if (!leNumero(p, Geometry::ROWS - 1, n) || *p++ != UNIT_SEPARATOR)
+            return false;
+        line[count] = n;
+        if (!leNumero(p, 32767, ttl[count]) || *p != UNIT_SEPARATOR)
+            return false;
+        text[count++] = ++p;
+        p = strchr(p, RECORD_SEPARATOR);
+        if (p == NULL)
+            break;
+        *p++ = '\0';
+    }
+    for (byte i = 0; i < count; i++)
+        defineLinha(line[i], text[i], strlen(text[i]), ttl[i]);
+    for (byte i = 0; i < count; i++)
+        atualizaDisplay(line[i]);
+    return true;
+}
+
+/**
+ * @brief Grava um padrão de bipes (comando BEEP_PATTERN).
+ *
+ * A mensagem é `POS:FREQ:DUR:PAUSA`, com até `BUZZER_MAX_BEEPS` trios
+ * `FREQ:DUR:PAUSA`. Um trio incompleto, um campo que não é número ou
+ * passa de 65535, bipes demais ou uma posição inexistente deixam o padrão
+ * gravado como estava.
+ *
+ * @param fields Mensagem do quadro.
+ * @return `false` se nada foi gravado.
+ */
+/*****************************************************************************/
+/*                                                                           */
+/*****************************************************************************/
+bool gravaBipes(char *fields) {
+    unsigned long value[BUZZER_MAX_BEEPS * 3];
+    Buzzer::Beep beeps[BUZZER_MAX_BEEPS];
+    byte n = 0;
+    unsigned long slot;
+    if (!leNumero(fields, BUZZER_SLOTS - 1, slot))
+        return false;
+    while (*fields == ':') {
+        if (n == BUZZER_MAX_BEEPS * 3)
+            return false;
+        fields++;
+        if (!leNumero(fields, 0xFFFF, value[n++]))
+            return false;
+    }
+    if (*fields != '\0' || n == 0 || n % 3 != 0)
+        return false;
+    for (byte i = 0; i < n / 3; i++) {
+        beeps[i].frequency = value[3 * i];
+        beeps[i].duration = value[3 * i + 1];
+        beeps[i].gap = value[3 * i + 2];
+    }
+    return buzzer.store(slot, beeps, n / 3);
+}
+
+/**
+ * @brief Começa um padrão embutido em segundo plano.
+ *
+ * @param pattern Bipes, em PROGMEM.
+ * @param count   Quantidade de bipes.
+ */
+/*****************************************************************************/
+/*                                                                           */
+/*****************************************************************************/
+void tocaPadrao(const Buzzer::Beep *pattern, byte count) {
+    buzzer.play(pattern, count);
+    tasks.wake(TASK_BUZZER);
 }
 
 /**
  * @brief Interpreta a mensagem recebida pela serial USB e atualiza a estrutura global netMessage.
  *
- * Esta função:
- * - Remove os marcadores de acentuação gráfica da string recebida (`usbProto.receivedChars`).
- * - Usa `strtok` para separar os campos da mensagem, assumindo o caractere `|` como delimitador.
+ * Esta função percorre `usbProto.receivedChars` uma única vez e, na mesma passada:
  * - Converte o primeiro campo para um código numérico (`netMessage.code`).
- * - Copia o segundo campo como texto da mensagem (`netMessage.message`).
- * - Converte o terceiro campo em milissegundos para o tempo de vida (`netMessage.TTL`).
+ * - Remove os marcadores de acentuação gráfica do segundo campo (só sem `LCD_ACCENTS`;
+ *   com a opção, os acentos chegam ao display) e o termina com `'\0'`
+ *   no lugar do `|`, sem copiá-lo: `netMessage.message` aponta para dentro do quadro.
+ * - Converte o terceiro campo em milissegundos para o tempo de vida (`netMessage.TTL`),
+ *   limitado a 32767 ms como no modo binário (`SerialProtocol::parseBinary()`).
+ *
+ * No TTL, o que não for dígito é ignorado. Um quadro com menos de três campos, ou com
+ * um código que não é só dígitos ou passa de 999, fica com `netMessage.code` 0, que
+ * `trataQuadros()` ignora: "1a0" não vira o código 10. Mensagens maiores que
+ * `MAX_STRING` são truncadas.
+ *
+ * No modo binário (`usbProto.binaryMode`) os campos são lidos por `SerialProtocol::parseBinary()`.
+ * Com `usbProto.checksumMode`, o CRC é conferido antes de tudo. Em ambos, um quadro corrompido
+ * recebe um NAK e fica com `netMessage.code` 0. Só depois disso o texto em UTF-8 é convertido
+ * (`SerialProtocol::decodeText()`); sem CRC, a máquina de recepção já o converteu.
  *
  * @note A função não recebe parâmetros nem retorna valor.
  *       Atua diretamente sobre as variáveis globais `usbProto` e `netMessage`.
@@ -316,16 +657,72 @@ void atualizaDisplay(int lines) {
 /*                                                                           */
 /*****************************************************************************/
 void parseMessage() {
-    char * strtokIndx; // this is used by strtok() as an index
-    usbProto.removeAccentMarker(usbProto.receivedChars);
-    strtokIndx = strtok(usbProto.receivedChars,"|");      // O código da mensagem
-    netMessage.code = atoi(strtokIndx);
-    
-    strtokIndx = strtok(NULL, "|");             // A mensagem
-    strcpy(netMessage.message, strtokIndx);
-        
-    strtokIndx = strtok(NULL, "|");             // Tempo de vida da mensagem em milissegundos
-    netMessage.TTL = atoi(strtokIndx);
+    if (usbProto.binaryMode) {
+        //Campos em posições fixas; um quadro com CRC ruim fica com código 0 e é ignorado
+        if (!usbProto.parseBinary(netMessage.code, netMessage.TTL, netMessage.message, netMessage.messageSize)) {
+            netMessage.code = 0;
+            usbProto.sendNak();
+            return;
+        }
+        netMessage.messageSize = usbProto.decodeText(netMessage.message, netMessage.messageSize);
+#ifndef LCD_ACCENTS
+        usbProto.removeAccentMarker(netMessage.message);
+#endif
+        return;
+    }
+    if (usbProto.checksumMode && !usbProto.verifyTrailer()) {
+        netMessage.code = 0;      //Quadro corrompido: pede só ele de novo
+        usbProto.sendNak();
+        return;
+    }
+    if (usbProto.checksumMode)
+        usbProto.decodeText(usbProto.receivedChars, strlen(usbProto.receivedChars));  //Conferido o CRC, o UTF-8 pode virar Windows-1252
+
+    byte field = 0;
+    unsigned long ttl = 0;        //Acumulado fora do int, que daria a volta acima de 32767
+    bool badCode = false;
+    netMessage.code = 0;
+    for (char *p = usbProto.receivedChars; *p != '\0'; p++) {
+        if (*p == '|') {
+            field++;
+            if (field == 1) {
+                netMessage.message = p + 1;
+            }
+            else if (field == 2) {
+                *p = '\0';
+                netMessage.messageSize = p - netMessage.message;
+            }
+            else
+                break;            //Campos além do terceiro são ignorados
+            continue;
+        }
+        switch (field) {
+          case 0:                 // O código da mensagem, de 1 a 999
+            if (*p >= '0' && *p <= '9' && netMessage.code <= 99)
+                netMessage.code = netMessage.code * 10 + (*p - '0');
+            else
+                badCode = true;
+            break;
+          case 1:                 // A mensagem
+#ifndef LCD_ACCENTS
+            *p = SerialProtocol::accentToAscii(*p);  //Com LCD_ACCENTS os acentos ficam, e GlyphCache os desenha
+#endif
+            break;
+          case 2:                 // Tempo de vida da mensagem em milissegundos
+            if (*p >= '0' && *p <= '9' && ttl <= 32767)
+                ttl = ttl * 10 + (*p - '0');
+            break;
+        }
+    }
+    netMessage.TTL = ttl > 32767 ? 32767 : ttl;
+    if (field < 2 || badCode) {
+        netMessage.code = 0;
+        return;
+    }
+    if (netMessage.messageSize > MAX_STRING) {
+        netMessage.message[MAX_STRING] = '\0';
+        netMessage.messageSize = MAX_STRING;
+    }
 }
 
 
@@ -339,11 +736,17 @@ void parseMessage() {
  * Inicializações realizadas:
  * - Define o pino do buzzer (`BUZZER`) como saída.
  * - Inicializa o display LCD (`lcd.init()`).
+ * - Ajusta o relógio do I2C para o maior aceito pelo LCD e pelo RTC (`i2c.begin()`).
+ * - Liga o pulso de 1 Hz do RTC e lê a hora e a temperatura uma vez (`rtcClock.begin()`).
  * - Configura contraste e backlight do display (mas não tem efeito no display que usamos).
  * - Desativa _autoscroll_ e cursor piscante.
  * - Limpa a tela do display (`lcd.clear()`).
- * - Configura a taxa de comunicação serial (`usbProto.setBaudRate(9600)`).
- * - Ajusta os tamanhos das mensagens padrão em `dispArray`.
+ * - Configura a taxa de comunicação serial (`usbProto.setBaudRate(DEFAULT_BAUD_RATE)`).
+ * - Carrega as mensagens padrão em `dispArray` e ajusta os tamanhos e a rolagem padrão.
+ * - Pinta a SRAM livre, para medir a folga da pilha (`health.begin()`).
+ * - Com `LATENCY_STATS`, liga o Timer1 usado nas medições de tempo de resposta.
+ * - Acorda as tarefas do `loop()` que rodam sem esperar evento.
+ * - Com `BENCHMARK` definido em config.h, mede a vazão de `receiveFrame()` e imprime na serial.
  *
  * @note Esta função não recebe parâmetros e não retorna valor.
  *       É executada uma única vez antes de `loop()`.
@@ -353,6 +756,7 @@ void parseMessage() {
 /*****************************************************************************/
 void setup() 
 {  
+  health.begin();       // Antes de tudo, com a pilha ainda rasa
   Wire.begin();
   rtc.begin();
   pinMode(BUZZER, OUTPUT);
@@ -363,50 +767,83 @@ void setup()
   lcd.noAutoscroll();
   lcd.noBlink();
   lcd.clear();                // Serve para limpar a tela do display
-  usbProto.setBaudRate(9600); // Envia e recebe a 9600 baud
-  //Ajusta o tamanho das strings default em dispArray
-  for (int i = 0; i < ROW; i++) {
+  lcdBuffer.reset();
+  i2c.begin();                // Depois de quem chama Wire.begin(), que volta o I2C para 100 kHz
+  rtcClock.begin(rtc);        // Última leitura da hora pelo I2C até o primeiro pulso do SQW
+#ifdef RX_ISR_DECODE
+  uart.decoder = &usbProto;   // Antes de ligar a USART, para nenhum byte escapar da máquina de recepção
+#endif
+  usbProto.setBaudRate(DEFAULT_BAUD_RATE); // Envia e recebe a 9600 baud
+  //Carrega as mensagens padrão e ajusta os tamanhos em dispArray
+  for (byte i = 0; i < Geometry::ROWS; i++) {
+    if (i < sizeof(defaultMessages) / sizeof(defaultMessages[0])) {
+      strncpy_P(dispArray[i].defaultMessage, (const char *) pgm_read_ptr(&defaultMessages[i]), Geometry::MSG_LEN);
+      dispArray[i].defaultMessage[Geometry::MSG_LEN] = '\0';
+    }
     dispArray[i].messageSize = strlen(dispArray[i].message);
     dispArray[i].defaultMessageSize = strlen(dispArray[i].defaultMessage);
+    dispArray[i].stepDelay = DISPLAY_UPDATE_DELAY;
+    dispArray[i].pauseStart = DISPLAY_UPDATE_DELAY * (1 + KEEP_AT_ZERO);
+    dispArray[i].pauseEnd = DISPLAY_UPDATE_DELAY * (1 + KEEP_AT_LAST);
   }
+#ifdef LATENCY_STATS
+  latency.begin();
+#endif
+  tasks.wake(TASK_DISPLAY);
+  tasks.wake(TASK_SERIAL);
+  tasks.wake(TASK_I2C);
+  tasks.wake(TASK_HEALTH);
+  tasks.after(TASK_RTC, RTC_TEMPERATURE_PERIOD);
+#ifdef BENCHMARK
+  runBenchmarks(*usbProto.port, usbProto.baudRate);
+#endif
 }
 
 /**
- * @brief Loop principal do firmware.
- *
- * O `loop()` executa continuamente o ciclo de atualização do display,
- * recepção de mensagens da TV-Box e execução dos comandos recebidos.
+ * @brief Tarefa `TASK_SERIAL`: recebe os quadros da TV-Box e executa os comandos.
  *
  * O comportamento segue o protocolo definido:
  * - **PING (100):** responde com uptime em ms e versão do firmware.
+ * - **STATS (101):** responde com uma página dos tempos de resposta (`LatencyStats::format()`) ou os zera.
+ * - **HEALTH (102):** responde com uma página dos indicadores de saúde (`formataSaude()`).
  * - **TIME (200):** atualiza linha 0 (sala, data, hora).
  * - **LECTURE_NAME (300):** atualiza linha 1 (nome da palestra).
  * - **SPEAKER (400):** atualiza linha 2 (nome do professor).
  * - **ATTENDEE (500):** atualiza linha 3 (participante) e força atualização imediata.
+ * - **SCREEN (210):** atualiza várias linhas, cada uma com o seu TTL, todas de uma vez (`defineTela()`).
  * - **SUCCESS (600):** _feedback_ sonoro curto (registro aceito, pode ser usuário/senha correto ou leitura correta de impressão digital).
  * - **FAIL (601):** _feedback_ sonoro duplo (registro rejeitado).
+ * - **BEEP_PATTERN (602):** Grava um padrão de bipes (`gravaBipes()`).
+ * - **BEEP_PLAY (603):** Toca um padrão gravado; uma posição vazia é recusada.
  * - **SETTIME (700):** Define a data e hora do RTC do Arduino.
- * - **GETTIME (701):** Obtém a data/hora do RTC, além da temperatura em graus Celcius.
+ * - **GETTIME (701):** Obtém a data/hora do RTC, além da temperatura em graus Celcius, das cópias em RAM (`rtcClock`).
+ * - **SETBAUD (800):** Responde com a taxa aceita e só então troca a taxa da serial.
+ * - **FRAMING (801):** Confirma no formato atual e passa a usar texto (0) ou binário (1).
+ * - **CHECKSUM (802):** Confirma no formato atual e liga (1) ou desliga (0) SEQ e CRC nos quadros de texto.
+ * - **ENCODING (803):** Confirma e passa a receber o texto em Windows-1252 (0) ou UTF-8 (1).
+ * - **SCROLL (900):** Ajusta passo, pausas e modo da rolagem de uma linha, que recomeça do início; o passo fica entre 1 e `SCROLL_MAX_STEP_DELAY` ms.
  *
- * ### Estrutura do loop
- * 1. Atualiza o display (`atualizaDisplay(-1)`).
- * 2. Recebe frame via `usbProto.receiveFrame()`.
- * 3. Se um frame válido foi recebido (`machState == RECEIVED`):
+ * ### Estrutura
+ * 1. Recebe frame via `usbProto.receiveFrame()`.
+ * 2. Se um frame válido foi recebido (`machState == RECEIVED`), trata-o e a
+ *    todos os que chegaram na mesma rajada (`usbProto.nextFrame()`):
  *    - Chama `parseMessage()` para decodificar.
  *    - Executa ação conforme `netMessage.code`.
- *    - Responde sempre `"002|OK"` após comandos de atualização.
+ *    - Responde `"002|OK"` após comandos de atualização (`respondeOK()`), ou
+ *      `"008|CODIGO"` quando os campos são inválidos (`respondeRecusa()`).
  *    - Atualiza mensagens em `dispArray` (conteúdo, tamanho, TTL, rolagem).
- *    - Gera sinais sonoros quando uma digital for lida ou usuário/senha do teclado.
- *    - Reinicia estado da máquina (`machState = START`).
- *    - Reinicia o ciclo (`goto CONTINUE`) sem esperar o `delay`.
- * 4. Se nada foi recebido → aguarda `LOOP_DELAY` antes do próximo ciclo.
+ *    - Começa os padrões de bipes quando uma digital for lida ou usuário/senha
+ *      do teclado; quem os toca, sem bloquear, é `tocaBuzzer()`.
+ * 3. Ao fim da rajada, redesenha uma única vez a linha 3, se houve `ATTENDEE`,
+ *    passando-a à frente na fila do LCD.
  *
  * @note
- * - O `goto CONTINUE` garante responsividade, reiniciando o ciclo imediatamente
- *   após processar uma mensagem (sem aguardar `LOOP_DELAY`).
- * - O uso de `atualizaDisplay(3)` no caso `ATTENDEE` deixa a linha 3 mais
- *   responsiva a eventos de digitação no teclado.
- * - A comunicação usa `usbProto`, que mantém a decodificação de um frame recebido.
+ * - O uso de `atualizaDisplay(3)` após `ATTENDEE` deixa a linha 3 mais
+ *   responsiva a eventos de digitação no teclado. Vários `ATTENDEE` na mesma
+ *   rajada custam um só redesenho, com o último texto recebido.
+ * - A comunicação usa `usbProto`, que mantém a fila dos quadros recebidos.
+ * - Volta a rodar em `SERIAL_POLL_PERIOD` mesmo sem bytes chegando, para
+ *   `receiveFrame()` vencer o prazo de uma troca de taxa não confirmada.
  *
  * @see atualizaDisplay
  * @see parseMessage
@@ -414,118 +851,351 @@ void setup()
 /*****************************************************************************/
 /*                                                                           */
 /*****************************************************************************/
-void loop() 
+void trataQuadros()
 {
- CONTINUE: 
-  atualizaDisplay(-1);        //Atualiza todas as linhas do display
+  tasks.after(TASK_SERIAL, SERIAL_POLL_PERIOD);
   usbProto.receiveFrame();
   if (usbProto.machState == SerialProtocol::RECEIVED) {
-    parseMessage();
-    switch (netMessage.code) {
-      case PING:
-        //Retorna "001|UPTIME em milissegundos|VERSION"
-        strReply[0] = '\0';
-        strcat(strReply, "001|");
-        uptime = millis();
-        itoa( uptime, auxStr, 10);
-        strcat(strReply, auxStr);
-        strcat(strReply, "|");
-        strcat(strReply, VERSION);
-        usbProto.sendFrame(strReply);
-        break;
+    bool attendeeUpdated = false;
+    do {
+#ifdef LATENCY_STATS
+      latency.start(usbProto.receivedStamp);
+#endif
+      parseMessage();
+#ifdef LATENCY_STATS
+      latency.parsed();
+#endif
+      switch (netMessage.code) {
+        case PING:
+          //Retorna "001|UPTIME em milissegundos|VERSION"
+          uptime = millis();
+          if (usbProto.binaryMode) {
+              usbProto.sendBinary(1, uptime, VERSION);
+              break;
+          }
+          strReply[0] = '\0';
+          strcat(strReply, "001|");
+          itoa( uptime, auxStr, 10);
+          strcat(strReply, auxStr);
+          strcat(strReply, "|");
+          strcat(strReply, VERSION);
+          usbProto.sendFrame(strReply);
+          break;
 
-      case TIME:
-        usbProto.sendFrame("002|OK|");
-        strcpy(dispArray[0].message, netMessage.message);
-        dispArray[0].messageSize = strlen(netMessage.message);
-        dispArray[0].TTL = millis() + netMessage.TTL;
-        dispArray[0].startPosition = 0;
-        dispArray[0].keepAtZeroPosition = KEEP_AT_ZERO;
-        break;
+        case STATS: {
+          //Retorna "006|PAGINA|dados"; sem LATENCY_STATS as páginas vêm vazias
+          byte page = atoi(netMessage.message);
+          auxStr[0] = '\0';
+#ifdef LATENCY_STATS
+          if (netMessage.message[0] == 'R')
+            latency.reset();
+          else
+            latency.format(page, auxStr);
+#endif
+          respondePagina(6, page, auxStr);
+          break;
+        }
 
-      case LECTURE_NAME:
-        usbProto.sendFrame("002|OK|");
-        strcpy(dispArray[1].message, netMessage.message);
-        dispArray[1].messageSize = strlen(netMessage.message);
-        dispArray[1].TTL = millis() + netMessage.TTL;
-        dispArray[1].startPosition = 0;
-        dispArray[1].keepAtZeroPosition = KEEP_AT_ZERO;
-        break;
+        case HEALTH: {
+          //Retorna "007|PAGINA|dados"
+          byte page = atoi(netMessage.message);
+          formataSaude(page, auxStr);
+          respondePagina(7, page, auxStr);
+          break;
+        }
 
-      case SPEAKER:
-        usbProto.sendFrame("002|OK|");
-        strcpy(dispArray[2].message, netMessage.message);
-        dispArray[2].messageSize = strlen(netMessage.message);
-        dispArray[2].TTL = millis() + netMessage.TTL;
-        dispArray[2].startPosition = 0;
-        dispArray[2].keepAtZeroPosition = KEEP_AT_ZERO;
-        break;
+        case TIME:
+        case LECTURE_NAME:
+        case SPEAKER:
+        case ATTENDEE: {
+          //Linha 0 a 3 conforme a centena; linhas que o display não tem são ignoradas
+          respondeOK();
+          byte line = netMessage.code / 100 - 2;
+          if (!defineLinha(line, netMessage.message, netMessage.messageSize, netMessage.TTL))
+            break;
+          if (netMessage.code == ATTENDEE)
+            attendeeUpdated = true;
+          else
+            atualizaDisplay(line);
+          break;
+        }
 
-      case ATTENDEE:
-        usbProto.sendFrame("002|OK|");
-        strcpy(dispArray[3].message, netMessage.message);
-        dispArray[3].messageSize = strlen(netMessage.message);
-        dispArray[3].TTL = millis() + netMessage.TTL;
-        dispArray[3].startPosition = 0;
-        dispArray[3].keepAtZeroPosition = KEEP_AT_ZERO;
-        atualizaDisplay(3);  //Atualiza forçosamente só a linha 3, o display fica mais responsivo a tecladas rápidas.
-        break;
+        case SCREEN:
+          //Uma só resposta e um só redesenho para todas as linhas do quadro; registros inválidos recusam o quadro inteiro
+          if (defineTela(netMessage.message))
+            respondeOK();
+          else
+            respondeRecusa(SCREEN);
+          break;
 
-      case SETTIME:
-        usbProto.sendFrame("002|OK|");
-        char * strtokIndx; // this is used by strtok() as an index
-        unsigned int year;
-        byte month;
-        byte day;
-        byte hour;
-        byte minute;
-        byte second;
-        strtokIndx = strtok(netMessage.message,":");      // Pega o ano
-        year = atoi(strtokIndx);
-        strtokIndx = strtok(NULL, ":");                   // Pega o mês
-        month = atoi(strtokIndx);
-        strtokIndx = strtok(NULL, ":");                   // Pega o dia
-        day = atoi(strtokIndx);
-        strtokIndx = strtok(NULL, ":");                   // Pega a hora
-        hour = atoi(strtokIndx);      
-        strtokIndx = strtok(NULL, ":");                   // Pega o minuto
-        minute = atoi(strtokIndx); 
-        strtokIndx = strtok(NULL, ":");                   // Pega o segundo
-        second = atoi(strtokIndx);        
-        rtc.adjust(DateTime(year, month, day, hour, minute, second));          
-        break;  
+        case SETTIME:
+          respondeOK();
+          char * strtokIndx; // this is used by strtok() as an index
+          unsigned int year;
+          byte month;
+          byte day;
+          byte hour;
+          byte minute;
+          byte second;
+          strtokIndx = strtok(netMessage.message,":");      // Pega o ano
+          year = atoi(strtokIndx);
+          strtokIndx = strtok(NULL, ":");                   // Pega o mês
+          month = atoi(strtokIndx);
+          strtokIndx = strtok(NULL, ":");                   // Pega o dia
+          day = atoi(strtokIndx);
+          strtokIndx = strtok(NULL, ":");                   // Pega a hora
+          hour = atoi(strtokIndx);      
+          strtokIndx = strtok(NULL, ":");                   // Pega o minuto
+          minute = atoi(strtokIndx); 
+          strtokIndx = strtok(NULL, ":");                   // Pega o segundo
+          second = atoi(strtokIndx);        
+          rtcClock.adjust(DateTime(year, month, day, hour, minute, second));
+          break;  
           
-      case GETTIME:
-        strReply[0] = '\0';
-        now = rtc.now();  
-        char tempBuf[12]; 
-        //Converte um float para uma string
-        dtostrf(rtc.getTemperature(), 4, 2, tempBuf); // largura=4, casas decimais=2
-        
-        sprintf(strReply, "003|%04d:%02d:%02d:%02d:%02d:%02d|%s",now.year(),
-                                                                 now.month(),
-                                                                 now.day(),
-                                                                 now.hour(),
-                                                                 now.minute(),
-                                                                 now.second(),
-                                                                 tempBuf);                                                     
-        usbProto.sendFrame(strReply);
-        break;
+        case GETTIME: {
+          //Da hora e da temperatura em RAM, sem I2C
+          if (usbProto.binaryMode) {
+              //Temperatura em centésimos de kelvin, para o varint não precisar de sinal
+              rtcClock.formatTime(auxStr);
+              usbProto.sendBinary(3, (unsigned long) (rtcClock.temperature + 27315L), auxStr);
+              break;
+          }
+          strcpy(strReply, "003|");
+          char *p = rtcClock.formatTime(strReply + 4);
+          *p++ = '|';
+          rtcClock.formatTemperature(p);
+          usbProto.sendFrame(strReply);
+          break;
+        }
+
+        case SETBAUD:
+          //Retorna "004|TAXA|"; uma taxa não suportada mantém a atual
+          unsigned long rate;
+          rate = strtoul(netMessage.message, NULL, 10);
+          if (!usbProto.isSupportedBaudRate(rate))
+              rate = usbProto.baudRate;
+          if (usbProto.binaryMode) {
+              usbProto.sendBinary(4, rate, "");
+              usbProto.changeBaudRate(rate, netMessage.TTL);
+              break;
+          }
+          strReply[0] = '\0';
+          strcat(strReply, "004|");
+          ultoa(rate, auxStr, 10);
+          strcat(strReply, auxStr);
+          strcat(strReply, "|");
+          usbProto.sendFrame(strReply);
+          usbProto.changeBaudRate(rate, netMessage.TTL);
+          break;
+
+        case FRAMING:
+          //Responde no formato antigo e só então troca
+          respondeOK();
+          usbProto.binaryMode = (atoi(netMessage.message) == 1);
+          break;
+
+        case CHECKSUM:
+          respondeOK();
+          usbProto.checksumMode = (atoi(netMessage.message) == 1);
+          break;
+
+        case ENCODING:
+          respondeOK();
+          usbProto.utf8Mode = (atoi(netMessage.message) == 1);
+          break;
+
+        case SCROLL: {
+          //"LINHA:PASSO:PAUSA_INICIO:PAUSA_FIM:MODO"; campos faltando ou que não são número,
+          //tempos acima de 16 bits, linha ou modo inexistentes são recusados
+          static const unsigned long fieldMax[5] = {Geometry::ROWS - 1, 0xFFFF, 0xFFFF, 0xFFFF, SCROLL_MOTION | SCROLL_EASE};
+          unsigned long field[5];
+          char *next = netMessage.message;
+          byte n = 0;
+          for (; n < 5; n++) {
+            if (!leNumero(next, fieldMax[n], field[n]) || *next != (n < 4 ? ':' : '\0'))
+              break;
+            next++;
+          }
+          if (n < 5 || (field[4] & SCROLL_MOTION) == SCROLL_MOTION) {
+            respondeRecusa(SCROLL);
+            break;
+          }
+          respondeOK();
+          Display &d = dispArray[field[0]];
+          d.stepDelay = constrain(field[1], 1UL, (unsigned long) SCROLL_MAX_STEP_DELAY);
+          d.pauseStart = field[2];
+          d.pauseEnd = field[3];
+          d.scrollMode = field[4];
+          d.restart();
+          atualizaDisplay(field[0]);
+          break;
+        }
         
-      case SUCCESS:
-        usbProto.sendFrame("002|OK|");
-        tone(BUZZER,1000,150);
-        break;
+        case SUCCESS:
+          respondeOK();
+          tocaPadrao(beepSuccess, sizeof(beepSuccess) / sizeof(beepSuccess[0]));
+          break;
 
-      case FAIL:
-        usbProto.sendFrame("002|OK|");
-        tone(BUZZER,2000,150);
-        delay(300);
-        tone(BUZZER,2000,150);
-        break;
+        case FAIL:
+          respondeOK();
+          tocaPadrao(beepFail, sizeof(beepFail) / sizeof(beepFail[0]));
+          break;
+
+        case BEEP_PATTERN:
+          if (gravaBipes(netMessage.message))
+            respondeOK();
+          else
+            respondeRecusa(BEEP_PATTERN);
+          break;
+
+        case BEEP_PLAY:
+          //Posição inexistente ou vazia é recusada
+          if (buzzer.playSlot(atoi(netMessage.message))) {
+            respondeOK();
+            tasks.wake(TASK_BUZZER);
+          }
+          else
+            respondeRecusa(BEEP_PLAY);
+          break;
+      }
+#ifdef LATENCY_STATS
+      latency.handled(netMessage.code);
+#endif
+    } while (usbProto.nextFrame());
+    if (attendeeUpdated) {
+        atualizaDisplay(3);  //Atualiza forçosamente só a linha 3, o display fica mais responsivo a tecladas rápidas.
+        lcdBuffer.promote(3);
     }
-    usbProto.machState = SerialProtocol::START;
-    goto CONTINUE;
   }
-  delay(LOOP_DELAY);  // delay do loop principal
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Tarefa `TASK_BUZZER`: inicia o próximo bipe e marca o prazo do seguinte.
+ *
+ * Quando o padrão termina a tarefa fica sem prazo, até o próximo `wake()`.
+ */
+/*****************************************************************************/
+/*                                                                           */
+/*****************************************************************************/
+void tocaBuzzer()
+{
+  unsigned long wait = buzzer.step();
+  if (wait != 0)
+    tasks.after(TASK_BUZZER, wait);
+}
+
+/**
+ * @brief Tarefa `TASK_DISPLAY`: avança as rolagens e troca as mensagens vencidas.
+ *
+ * `atualizaDisplay()` marca o próximo prazo da tarefa.
+ */
+/*****************************************************************************/
+/*                                                                           */
+/*****************************************************************************/
+void tarefaDisplay()
+{
+  atualizaDisplay(-1);
+}
+
+/**
+ * @brief Tarefa `TASK_LCD`: envia ao LCD no máximo `LCD_FLUSH_BUDGET` caracteres do que mudou.
+ *
+ * Como cada passada é curta, a recepção serial, de prioridade maior, nunca
+ * espera mais que uma fatia, não importa quanto da tela mudou. Com
+ * `LCD_ACCENTS`, uma carga de letra na CGRAM (`GlyphCache::update()`) entra
+ * no mesmo limite: a passada que carrega uma letra não envia caracteres.
+ */
+/*****************************************************************************/
+/*                                                                           */
+/*****************************************************************************/
+void enviaLcd()
+{
+#ifdef LCD_ACCENTS
+  byte used = glyphs.update(lcd, lcdBuffer);  //Uma carga da CGRAM gasta a passada inteira
+  if (used < LCD_FLUSH_BUDGET)
+    lcdBuffer.flush(lcd, LCD_FLUSH_BUDGET - used, glyphs);
+#else
+  lcdBuffer.flush(lcd, LCD_FLUSH_BUDGET);
+#endif
+}
+
+/**
+ * @brief Tarefa `TASK_I2C`: recalcula as taxas do barramento uma vez por segundo.
+ */
+/*****************************************************************************/
+/*                                                                           */
+/*****************************************************************************/
+void tarefaI2c()
+{
+  i2c.updateRates();
+  tasks.after(TASK_I2C, I2C_RATES_PERIOD);
+}
+
+/**
+ * @brief Tarefa `TASK_RTC`: lê a temperatura a cada `RTC_TEMPERATURE_PERIOD`.
+ *
+ * Também é acordada pelo `loop()` no primeiro pulso do SQW e no pulso
+ * seguinte a cada leitura da temperatura, para reler a hora alinhada com o
+ * pulso (`RtcClock::pending()`).
+ */
+/*****************************************************************************/
+/*                                                                           */
+/*****************************************************************************/
+void tarefaRelogio()
+{
+  rtcClock.refresh();
+  tasks.after(TASK_RTC, RTC_TEMPERATURE_PERIOD);
+}
+
+/**
+ * @brief Tarefa `TASK_HEALTH`: recalcula as passadas do `loop()` por segundo.
+ */
+/*****************************************************************************/
+/*                                                                           */
+/*****************************************************************************/
+void tarefaSaude()
+{
+  health.updateRate(tasks.passes);
+  tasks.after(TASK_HEALTH, HEALTH_PERIOD);
+}
+
+/**
+ * @brief Loop principal do firmware.
+ *
+ * Cada passada executa uma tarefa de `tasks`, a de maior prioridade entre as
+ * prontas (ver `TaskId`):
+ * 1. Acorda `TASK_SERIAL` se há bytes ou quadros esperando
+ *    (`usbProto.inputPending()`), `TASK_LCD` se a tela em RAM difere do LCD
+ *    (`lcdBuffer.pending()`) e `TASK_RTC` se a hora em RAM espera o
+ *    alinhamento com o pulso do SQW (`rtcClock.pending()`). Com
+ *    `LATENCY_STATS`, marca a fila de transmissão vazia (`latency.drained()`).
+ * 2. Executa a tarefa pronta, até o fim; as tarefas com prazo vencido também
+ *    estão prontas.
+ * 3. Sem tarefa pronta, dorme até a próxima interrupção (`tasks.idle()`).
+ *
+ * @note
+ * - Um quadro que chega com o processador dormindo o acorda pela interrupção
+ *   da serial: não há mais o atraso fixo de um `delay()` no laço.
+ * - O pior tempo até um comando começar a ser tratado é a maior duração entre
+ *   as outras tarefas (`tasks.longest`), já que nenhuma é interrompida.
+ *
+ * @see trataQuadros
+ */
+/*****************************************************************************/
+/*                                                                           */
+/*****************************************************************************/
+void loop() 
+{
+  if (usbProto.inputPending())
+    tasks.wake(TASK_SERIAL);
+  if (lcdBuffer.pending())
+    tasks.wake(TASK_LCD);
+  if (rtcClock.pending())
+    tasks.wake(TASK_RTC);
+#ifdef LATENCY_STATS
+  if (latency.draining() && usbProto.pendingOutput() == 0)
+    latency.drained();
+#endif
+  if (!tasks.run())
+    tasks.idle();
+}
@@ -0,0 +1,217 @@
+#include "bench.h"
+
+#ifdef BENCHMARK
+
+/*****************************************************************************/
+/* Cenários sintéticos. Ficam em PROGMEM para não ocupar a SRAM.             */
+/*****************************************************************************/
+static const char scenPlain[]    PROGMEM = "<500|Fulano de Tal da Silva|5000>";
+static const char scenEscape[]   PROGMEM = "<500|\\<\\>\\\\a\\<\\>\\\\b\\<\\>\\\\c|0>";
+static const char scenGarbage[]  PROGMEM = "\r\n#lixo#\r\n<500|Fulano de Tal|5000>xyz";
+static const char scenBurst[]    PROGMEM = "<100|0|0><200|Sala 1|0><600|0|0>";
+static const char scenRestart[]  PROGMEM = "<500|incomplet<500|Fulano de Tal|5000>";
+static const char scenUtf8[]     PROGMEM = "<500|João da Conceição – Computação|5000>";
+
+static const char namePlain[]    PROGMEM = "simples";
+static const char nameEscape[]   PROGMEM = "escapes";
+static const char nameGarbage[]  PROGMEM = "lixo entre quadros";
+static const char nameBurst[]    PROGMEM = "consecutivos";
+static const char nameRestart[]  PROGMEM = "reinicio em '<'";
+static const char nameUtf8[]     PROGMEM = "utf-8";
+
+struct Scenario {
+	const char *name;
+	const char *data;
+	unsigned int size;
+	bool utf8;         // Sessão em UTF-8 (SerialProtocol::utf8Mode)
+};
+
+static const Scenario scenarios[] = {
+	{namePlain,   scenPlain,   sizeof(scenPlain) - 1,   false},
+	{nameEscape,  scenEscape,  sizeof(scenEscape) - 1,  false},
+	{nameGarbage, scenGarbage, sizeof(scenGarbage) - 1, false},
+	{nameBurst,   scenBurst,   sizeof(scenBurst) - 1,   false},
+	{nameRestart, scenRestart, sizeof(scenRestart) - 1, false},
+	{nameUtf8,    scenUtf8,    sizeof(scenUtf8) - 1,    true},
+};
+
+#define BENCH_BYTES 20000UL   // Bytes entregues por cenário
+#define FUZZ_FRAMES 2000U     // Quadros aleatórios da verificação do UTF-8
+
+/*****************************************************************************/
+/* MemoryStream                                                              */
+/* Como a Serial, oferece no máximo SERIAL_RX_BUFFER_SIZE - 1 bytes de uma   */
+/* vez: cada receiveFrame() decodifica uma porção limitada.                  */
+/*****************************************************************************/
+MemoryStream::MemoryStream(const char *data, unsigned int size, unsigned long repeat)
+	: data(data), size(size), pos(0), remaining(repeat * size)
+{
+}
+
+int MemoryStream::available() {
+	return remaining > SERIAL_RX_BUFFER_SIZE - 1 ? SERIAL_RX_BUFFER_SIZE - 1 : (int) remaining;
+}
+
+int MemoryStream::read() {
+	if (remaining == 0)
+		return -1;
+	int c = pgm_read_byte(data + pos);
+	if (++pos == size)
+		pos = 0;
+	remaining--;
+	return c;
+}
+
+int MemoryStream::peek() {
+	return remaining == 0 ? -1 : pgm_read_byte(data + pos);
+}
+
+size_t MemoryStream::write(uint8_t) {
+	return 1;
+}
+
+/*****************************************************************************/
+/* Imprime uma string que está em PROGMEM.                                   */
+/*****************************************************************************/
+static void printP(Print &out, const char *str) {
+	char c;
+	while ((c = pgm_read_byte(str++)) != '\0')
+		out.write(c);
+}
+
+/*****************************************************************************/
+/* Gerador xorshift de 32 bits, com semente fixa para a sequência se repetir */
+/* a cada execução.                                                          */
+/*****************************************************************************/
+static uint32_t fuzzState = 0x2545F491UL;
+
+static byte fuzzByte() {
+	fuzzState ^= fuzzState << 13;
+	fuzzState ^= fuzzState >> 17;
+	fuzzState ^= fuzzState << 5;
+	return fuzzState;
+}
+
+/*****************************************************************************/
+/* Byte do conteúdo de um quadro aleatório: metade ASCII, o resto líderes e  */
+/* continuações de UTF-8 ou qualquer byte. '<', '>' e '\' ficam de fora,     */
+/* pois o que se verifica é só o UTF-8.                                      */
+/*****************************************************************************/
+static byte fuzzContent() {
+	byte r = fuzzByte();
+	byte c;
+	switch (r & 0x07) {
+		case 0: case 1: case 2: case 3: c = 'a' + (r >> 3); break;
+		case 4:  c = 0xC2 + (r >> 6); break;                  // Líder de 2 bytes (Latin-1)
+		case 5:  c = 0x80 | (r >> 3); break;                  // Continuação
+		case 6:  c = (r & 0x08) ? 0xE2 : 0xF0; break;         // Líder de 3 ou 4 bytes
+		default: c = fuzzByte(); break;
+	}
+	return (c == '<' || c == '>' || c == '\\') ? 'x' : c;
+}
+
+/*****************************************************************************/
+/* fuzzUtf8()                                                                */
+/* Compara a conversão byte a byte da máquina de recepção com a conversão do */
+/* quadro inteiro (utf8ToWin1252(), a mesma usada com CRC). O quadro deve    */
+/* chegar igual, ou ser descartado quando o texto convertido não cabe.       */
+/*****************************************************************************/
+static void fuzzUtf8(Print &out) {
+	MemoryStream none(NULL, 1, 0);
+	SerialProtocol proto(none);
+	char raw[MAX_PROTOCOL_MESSAGE + 9];
+	unsigned int received = 0;
+	unsigned int mismatches = 0;
+	proto.utf8Mode = true;
+	for (unsigned int i = 0; i < FUZZ_FRAMES; i++) {
+		byte size = fuzzByte() % sizeof(raw);
+		proto.decodeByte('<');
+		for (byte j = 0; j < size; j++) {
+			raw[j] = fuzzContent();
+			proto.decodeByte(raw[j]);
+		}
+		proto.decodeByte('>');
+		byte expected = utf8ToWin1252(raw, size);
+
+		bool got = proto.nextFrame();
+		if (got)
+			received++;
+		if (expected > MAX_PROTOCOL_MESSAGE ? got
+		    : !got || proto.receivedSize != expected || memcmp(proto.receivedChars, raw, expected + 1) != 0)
+			mismatches++;
+	}
+	out.print(F("fuzz utf-8: "));
+	out.print(FUZZ_FRAMES);
+	out.print(F(" quadros, "));
+	out.print(received);
+	out.print(F(" recebidos, "));
+	out.print(mismatches);
+	out.println(F(" divergencias"));
+}
+
+/*****************************************************************************/
+/* runBenchmarks()                                                           */
+/* Os quadros são consumidos como em trataQuadros(): depois de cada          */
+/* receiveFrame(), todos os que estão na fila, até nextFrame() falhar.       */
+/* O Timer1 conta ciclos (prescaler 1) em cada chamada; uma chamada          */
+/* decodifica no máximo SERIAL_RX_BUFFER_SIZE - 1 bytes, bem menos que os    */
+/* 65536 ciclos de uma volta do contador. Sem o laço de fora, o tempo medido */
+/* é só o da recepção.                                                       */
+/*****************************************************************************/
+void runBenchmarks(Print &out, unsigned long baudRate) {
+	byte timerA = TCCR1A;
+	byte timerB = TCCR1B;
+	TCCR1A = 0;
+	TCCR1B = _BV(CS10);
+	for (unsigned int s = 0; s < sizeof(scenarios) / sizeof(scenarios[0]); s++) {
+		unsigned long repeat = BENCH_BYTES / scenarios[s].size;
+		unsigned long bytes  = repeat * scenarios[s].size;
+		unsigned long frames = 0;
+		unsigned long cycles = 0;
+		MemoryStream input(scenarios[s].data, scenarios[s].size, repeat);
+		SerialProtocol proto(input);
+		proto.utf8Mode = scenarios[s].utf8;
+
+		while (input.available() > 0) {
+			uint16_t start = TCNT1;
+			proto.receiveFrame();
+			if (proto.machState == SerialProtocol::RECEIVED) {
+				do
+					frames++;
+				while (proto.nextFrame());
+			}
+			cycles += (uint16_t) (TCNT1 - start);
+		}
+		if (cycles == 0)
+			cycles = 1;
+
+		unsigned long bytesPerSec  = (unsigned long) ((float) bytes * F_CPU / cycles);
+		float cyclesPerByte        = (float) cycles / bytes;
+		unsigned long framesPerSec = (unsigned long) ((float) frames * F_CPU / cycles);
+		float headroom             = (float) bytesPerSec / (baudRate / 10);
+
+		printP(out, scenarios[s].name);
+		out.print(F(": "));
+		out.print(frames);
+		out.print(F(" quadros, "));
+		out.print(bytesPerSec);
+		out.print(F(" B/s, "));
+#ifdef __AVR__
+		out.print(cyclesPerByte, 1);
+		out.print(F(" ciclos/B, "));
+#else
+		// No PC o TCNT1 simulado anda pelo relógio do PC: o que vale é o tempo
+		out.print(cyclesPerByte * 1e9 / F_CPU, 1);
+		out.print(F(" ns/B no PC, "));
+#endif
+		out.print(framesPerSec);
+		out.print(F(" quadros/s, folga "));
+		out.print(headroom, 1);
+		out.println(F("x"));
+	}
+	TCCR1A = timerA;
+	TCCR1B = timerB;
+	fuzzUtf8(out);
+}
+
+#endif // BENCHMARK
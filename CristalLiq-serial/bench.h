@@ -0,0 +1,56 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "frame.h"
+
+#ifdef BENCHMARK
+
+/**
+ * @class MemoryStream
+ * @brief `Stream` somente leitura sobre um trecho em memória de programa, repetido N vezes.
+ *
+ * Substitui a `Serial` nas medições: SerialProtocol lê os bytes sintéticos
+ * como se viessem da TV-Box. O que for escrito é descartado.
+ */
+class MemoryStream : public Stream {
+	public:
+		/**
+		* @param data    Bytes do cenário, em PROGMEM.
+		* @param size    Quantidade de bytes em `data`.
+		* @param repeat  Quantas vezes o trecho é entregue em sequência.
+		*/
+		MemoryStream(const char *data, unsigned int size, unsigned long repeat);
+		int available();
+		int read();
+		int peek();
+		size_t write(uint8_t c);
+		using Print::write;
+	private:
+		const char *data;
+		unsigned int size;
+		unsigned int pos;
+		unsigned long remaining;
+};
+
+/**
+ * @brief Mede a vazão da máquina de recepção nos cenários sintéticos.
+ *
+ * Para cada cenário imprime os quadros recebidos, bytes/s, ciclos/byte,
+ * quadros/s e a folga em relação à taxa da linha serial (quantas vezes o
+ * decodificador é mais rápido que os bytes chegam). O tempo é contado em
+ * ciclos pelo Timer1, que é reconfigurado durante as medições e restaurado
+ * no fim. Compilado para o PC (`test/bench_main.cpp`), o Timer1 simulado
+ * segue o relógio do PC, e no lugar dos ciclos/byte sai o tempo em
+ * nanossegundos por byte; as taxas e a folga são as do PC, não as da placa.
+ *
+ * Depois, passa quadros aleatórios numa sessão em UTF-8 pela máquina de
+ * recepção e confere cada um com `utf8ToWin1252()`; imprime quantos divergiram.
+ *
+ * @param out       Onde os resultados são impressos.
+ * @param baudRate  Taxa da linha usada no cálculo da folga.
+ */
+void runBenchmarks(Print &out, unsigned long baudRate);
+
+#endif // BENCHMARK
+
+#endif // BENCH_H
@@ -0,0 +1,88 @@
+#include "buzzer.h"
+
+/*****************************************************************************/
+/* Padrões embutidos. O FAIL repete o tone(2000, 150) depois de 300 ms,      */
+/* como fazia o antigo delay(300).                                           */
+/*****************************************************************************/
+const Buzzer::Beep beepSuccess[1] PROGMEM = {{1000, 150, 0}};
+const Buzzer::Beep beepFail[2] PROGMEM    = {{2000, 150, 150}, {2000, 150, 0}};
+
+/*****************************************************************************/
+/* Construtor                                                                */
+/*****************************************************************************/
+Buzzer::Buzzer(byte pin) : pattern(NULL), inFlash(false), count(0), next(0), pin(pin)
+{
+	memset(slotSize, 0, sizeof(slotSize));
+}
+
+/*****************************************************************************/
+/* play()                                                                    */
+/*****************************************************************************/
+void Buzzer::play(const Beep *pattern, byte count) {
+	this->pattern = pattern;
+	this->count = count;
+	inFlash = true;
+	next = 0;
+}
+
+/*****************************************************************************/
+/* playSlot()                                                                */
+/*****************************************************************************/
+bool Buzzer::playSlot(byte slot) {
+	if (slot >= BUZZER_SLOTS || slotSize[slot] == 0)
+		return false;
+	pattern = slots[slot];
+	count = slotSize[slot];
+	inFlash = false;
+	next = 0;
+	return true;
+}
+
+/*****************************************************************************/
+/* store()                                                                   */
+/* Flash e SRAM são espaços de endereço separados no AVR: um padrão em       */
+/* PROGMEM pode ter o mesmo endereço numérico que uma posição de `slots`.    */
+/*****************************************************************************/
+bool Buzzer::store(byte slot, const Beep *beeps, byte count) {
+	if (slot >= BUZZER_SLOTS || count > BUZZER_MAX_BEEPS)
+		return false;
+	if (!inFlash && pattern == slots[slot])
+		stop();
+	memcpy(slots[slot], beeps, count * sizeof(Beep));
+	slotSize[slot] = count;
+	return true;
+}
+
+/*****************************************************************************/
+/* step()                                                                    */
+/* O tone() desliga o som sozinho ao fim da duração; a pausa é só a espera   */
+/* até o próximo bipe. O padrão termina uma chamada depois do último bipe.   */
+/*****************************************************************************/
+unsigned long Buzzer::step() {
+	if (pattern == NULL)
+		return 0;
+	if (next == count) {
+		stop();
+		return 0;
+	}
+	Beep b;
+	if (inFlash)
+		memcpy_P(&b, &pattern[next], sizeof(b));
+	else
+		b = pattern[next];
+	next++;
+	if (b.frequency != 0 && b.duration != 0)
+		tone(pin, b.frequency, b.duration);
+	else
+		noTone(pin);
+	unsigned long wait = (unsigned long) b.duration + b.gap;
+	return wait == 0 ? 1 : wait;
+}
+
+/*****************************************************************************/
+/* stop()                                                                    */
+/*****************************************************************************/
+void Buzzer::stop() {
+	pattern = NULL;
+	noTone(pin);
+}
@@ -0,0 +1,101 @@
+#ifndef BUZZER_H
+#define BUZZER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+/**
+ * @class Buzzer
+ * @brief Toca sequências de bipes sem bloquear o `loop()`.
+ *
+ * Um padrão é uma lista de bipes, cada um com frequência, duração e a pausa
+ * até o próximo. O som de cada bipe é gerado e desligado pelo `tone()`,
+ * que usa o Timer2. Entre um bipe e outro quem espera é o chamador: `step()`
+ * inicia o bipe atual e devolve quanto tempo falta para o próximo, que o
+ * `loop()` usa como prazo de uma tarefa do escalonador.
+ *
+ * Os padrões embutidos (`beepSuccess`, `beepFail`) ficam em PROGMEM; os
+ * gravados pela TV-Box ficam em `slots`, na SRAM.
+ */
+class Buzzer {
+	public:
+		/**
+		* @brief Um bipe do padrão. Frequência 0 é silêncio.
+		*/
+		struct Beep {
+			uint16_t frequency;  /**< Frequência em Hz. */
+			uint16_t duration;   /**< Duração do som em milissegundos. */
+			uint16_t gap;        /**< Silêncio depois do som, em milissegundos. */
+		};
+
+		/**
+		* @brief Padrões gravados pela TV-Box.
+		*/
+		Beep slots[BUZZER_SLOTS][BUZZER_MAX_BEEPS];
+
+		/**
+		* @brief Quantidade de bipes de cada padrão gravado; 0 se a posição está vazia.
+		*/
+		byte slotSize[BUZZER_SLOTS];
+
+		/**
+		* @param pin Pino digital ligado ao _buzzer_.
+		*/
+		explicit Buzzer(byte pin);
+
+		/**
+		* @brief Começa um padrão embutido, interrompendo o que estiver tocando.
+		*
+		* @param pattern Bipes, em PROGMEM.
+		* @param count   Quantidade de bipes.
+		*/
+		void play(const Beep *pattern, byte count);
+
+		/**
+		* @brief Começa um padrão gravado, interrompendo o que estiver tocando.
+		*
+		* @return `false` se a posição não existe ou está vazia.
+		*/
+		bool playSlot(byte slot);
+
+		/**
+		* @brief Grava um padrão numa posição de `slots`.
+		*
+		* Se essa posição estiver tocando, para antes.
+		*
+		* @return `false` se a posição não existe ou há bipes demais.
+		*/
+		bool store(byte slot, const Beep *beeps, byte count);
+
+		/**
+		* @brief Inicia o próximo bipe do padrão.
+		*
+		* @return Milissegundos até a próxima chamada, ou 0 quando o padrão
+		*         terminou (o som já foi desligado).
+		*/
+		unsigned long step();
+
+		/**
+		* @brief Interrompe o padrão e desliga o som.
+		*/
+		void stop();
+
+	private:
+		const Beep *pattern;  // Padrão tocando; NULL se nenhum
+		bool inFlash;         // `pattern` está em PROGMEM
+		byte count;
+		byte next;            // Próximo bipe a iniciar
+		byte pin;
+};
+
+/**
+ * @brief Padrão do SUCCESS: um bipe curto.
+ */
+extern const Buzzer::Beep beepSuccess[1] PROGMEM;
+
+/**
+ * @brief Padrão do FAIL: dois bipes agudos.
+ */
+extern const Buzzer::Beep beepFail[2] PROGMEM;
+
+#endif // BUZZER_H
@@ -0,0 +1,217 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+/**
+ * @file config.h
+ * @brief Opções de compilação do _firmware_.
+ *
+ * O Arduino IDE não permite passar `-D` por projeto, então as opções que
+ * precisam ser vistas tanto pelo sketch quanto pelos arquivos `.cpp` ficam
+ * aqui. Basta descomentar a linha desejada e recompilar.
+ */
+
+/**
+ * @def BENCHMARK
+ * @brief Executa as medições de vazão de SerialProtocol::receiveFrame() no `setup()`.
+ *
+ * Os resultados saem pela `Serial`. Também serve para rodar o mesmo binário
+ * num simulador de AVR (simavr), pois o tempo é contado em ciclos pelo
+ * Timer1. No PC, o executável `bench` de test/ roda as mesmas medições.
+ */
+//#define BENCHMARK
+
+/**
+ * @def USE_NATIVE_UART
+ * @brief Usa o driver próprio da USART0 (NativeUart) no lugar da `Serial`.
+ *
+ * A recepção passa a ser feita pela interrupção de RX, que guarda os bytes
+ * numa fila de `RX_BUFFER_SIZE` posições. Com essa opção o sketch não pode
+ * usar `Serial`, pois as duas disputariam o mesmo vetor de interrupção.
+ */
+//#define USE_NATIVE_UART
+
+/**
+ * @def RX_BUFFER_SIZE
+ * @brief Posições da fila de recepção da NativeUart (potência de 2, até 256).
+ */
+#ifndef RX_BUFFER_SIZE
+#define RX_BUFFER_SIZE 64
+#endif
+
+/**
+ * @def TX_BUFFER_SIZE
+ * @brief Posições da fila de transmissão da NativeUart (potência de 2, até 256).
+ *
+ * A fila é esvaziada pela interrupção de registrador vazio (UDRE); enquanto
+ * houver espaço, `SerialProtocol::sendFrame()` retorna sem esperar a linha.
+ * Sem `USE_NATIVE_UART` vale o buffer de 64 bytes da `Serial`.
+ */
+#ifndef TX_BUFFER_SIZE
+#define TX_BUFFER_SIZE 128
+#endif
+
+/**
+ * @def RX_ISR_DECODE
+ * @brief A própria interrupção de RX roda a máquina de recepção e enfileira quadros completos.
+ *
+ * Exige `USE_NATIVE_UART`. Os quadros vão para a fila de `FRAME_QUEUE_SIZE`
+ * posições e nenhum byte se perde enquanto o `loop()` está bloqueado.
+ */
+//#define RX_ISR_DECODE
+
+/**
+ * @def FRAME_QUEUE_SIZE
+ * @brief Posições da fila de quadros decodificados (potência de 2).
+ *
+ * Cabem `FRAME_QUEUE_SIZE - 1` quadros prontos mais o que está chegando.
+ * Cada posição ocupa `MAX_PROTOCOL_MESSAGE + 1` bytes de SRAM (64, com o
+ * trailer do modo com CRC).
+ */
+#ifndef FRAME_QUEUE_SIZE
+#define FRAME_QUEUE_SIZE 4
+#endif
+
+/**
+ * @def LATENCY_STATS
+ * @brief Mede o tempo de resposta de cada código de comando (comando STATS, 101).
+ *
+ * Usa o Timer1, que passa a contar livre. Sem a opção, nenhuma marcação
+ * é compilada.
+ */
+//#define LATENCY_STATS
+
+/**
+ * @def LATENCY_SLOTS
+ * @brief Códigos de comando distintos medidos com `LATENCY_STATS`.
+ *
+ * Cada posição ocupa 32 bytes de SRAM.
+ */
+#ifndef LATENCY_SLOTS
+#define LATENCY_SLOTS 6
+#endif
+
+/**
+ * @def BUZZER_SLOTS
+ * @brief Padrões de bipes que a TV-Box pode gravar (comando 602), além dos embutidos.
+ *
+ * Cada posição ocupa `BUZZER_MAX_BEEPS * 6 + 1` bytes de SRAM.
+ */
+#ifndef BUZZER_SLOTS
+#define BUZZER_SLOTS 2
+#endif
+
+/**
+ * @def BUZZER_MAX_BEEPS
+ * @brief Bipes (frequência, duração e pausa) em cada padrão gravado.
+ */
+#ifndef BUZZER_MAX_BEEPS
+#define BUZZER_MAX_BEEPS 4
+#endif
+
+/**
+ * @def LCD_16X2
+ * @brief Display de 16 colunas e 2 linhas no lugar do 20x4.
+ *
+ * Só as linhas 0 (TIME) e 1 (LECTURE_NAME) existem; SPEAKER e ATTENDEE são
+ * confirmados e ignorados.
+ */
+//#define LCD_16X2
+
+/**
+ * @def LCD_40X4
+ * @brief Display de 40 colunas e 4 linhas no lugar do 20x4.
+ *
+ * Essas telas têm dois controladores e exigem `LCD_PARALLEL`, com o segundo
+ * pino E no pino 11.
+ */
+//#define LCD_40X4
+
+/**
+ * @def LCD_ACCENTS
+ * @brief Exibe as letras acentuadas do português com desenhos próprios na CGRAM do LCD.
+ *
+ * As mensagens deixam de perder os acentos na recepção. Até 8 letras
+ * acentuadas diferentes aparecem na tela ao mesmo tempo (GlyphCache); as
+ * demais saem sem acento, como sem esta opção.
+ */
+#define LCD_ACCENTS
+
+/**
+ * @def LCD_PARALLEL
+ * @brief Liga o LCD direto nos pinos do Arduino em vez do módulo I2C (PCF8574).
+ *
+ * Usa o driver Hd44780, com escrita nos registradores das portas e leitura
+ * do _busy flag_. Fiação: RS no pino 8, RW no 9, E no 10 e D4..D7 nos pinos
+ * 4 a 7. O RW precisa estar ligado, não aterrado.
+ */
+//#define LCD_PARALLEL
+
+/**
+ * @def LCD_PARALLEL_8BIT
+ * @brief Com `LCD_PARALLEL`, usa os 8 bits de dados, com D0..D3 em A0..A3.
+ *
+ * Metade dos pulsos de E do modo de 4 bits, à custa de mais quatro pinos.
+ */
+//#define LCD_PARALLEL_8BIT
+
+/**
+ * @def LCD_LIQUIDCRYSTAL_I2C
+ * @brief Usa a biblioteca `LiquidCrystal_I2C` para o módulo I2C do LCD.
+ *
+ * Sem esta opção (e sem `LCD_PARALLEL`), o módulo é acionado pelo driver
+ * Hd44780 com as escritas agrupadas em transações de até 32 bytes, em vez
+ * de uma transação por byte.
+ */
+//#define LCD_LIQUIDCRYSTAL_I2C
+
+/**
+ * @def I2C_LCD_MAX_CLOCK
+ * @brief Maior frequência do I2C aceita pelo módulo do LCD.
+ *
+ * O datasheet do PCF8574 garante 100 kHz. A maioria dos módulos funciona a
+ * 400 kHz; nesse caso, basta trocar o valor.
+ */
+#ifndef I2C_LCD_MAX_CLOCK
+#define I2C_LCD_MAX_CLOCK 100000UL
+#endif
+
+/**
+ * @def I2C_RTC_MAX_CLOCK
+ * @brief Maior frequência do I2C aceita pelo DS3231 (_fast mode_).
+ */
+#ifndef I2C_RTC_MAX_CLOCK
+#define I2C_RTC_MAX_CLOCK 400000UL
+#endif
+
+/**
+ * @def RTC_SQW_PIN
+ * @brief Pino ligado à saída SQW do DS3231, que dá o pulso de 1 Hz do relógio em RAM (RtcClock).
+ *
+ * Precisa ser uma interrupção externa; no Nano, o 2 (INT0) é do _buzzer_ e
+ * sobra o 3 (INT1). A saída é de dreno aberto e o pino usa o _pull-up_ interno.
+ */
+#ifndef RTC_SQW_PIN
+#define RTC_SQW_PIN 3
+#endif
+
+#if defined(RX_ISR_DECODE) && !defined(USE_NATIVE_UART)
+#error "RX_ISR_DECODE exige USE_NATIVE_UART"
+#endif
+
+#if defined(LCD_PARALLEL_8BIT) && !defined(LCD_PARALLEL)
+#error "LCD_PARALLEL_8BIT exige LCD_PARALLEL"
+#endif
+
+#if defined(LCD_16X2) && defined(LCD_40X4)
+#error "Escolha só uma geometria do display"
+#endif
+
+#if defined(LCD_40X4) && !defined(LCD_PARALLEL)
+#error "LCD_40X4 exige LCD_PARALLEL"
+#endif
+
+#if defined(LCD_PARALLEL) && defined(LCD_LIQUIDCRYSTAL_I2C)
+#error "Escolha só um entre LCD_PARALLEL e LCD_LIQUIDCRYSTAL_I2C"
+#endif
+
+#endif // CONFIG_H
@@ -0,0 +1,27 @@
+#include "crc16.h"
+
+// Resto da divisão de cada nibble, já deslocado para os 4 bits altos, pelo polinômio 0x1021
+static const uint16_t crcNibbleTable[16] PROGMEM = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+/*****************************************************************************/
+/* crc16Update()                                                             */
+/* Processa o nibble alto e depois o baixo.                                  */
+/*****************************************************************************/
+uint16_t crc16Update(uint16_t crc, uint8_t b) {
+    crc = (crc << 4) ^ pgm_read_word(&crcNibbleTable[(crc >> 12) ^ (b >> 4)]);
+    crc = (crc << 4) ^ pgm_read_word(&crcNibbleTable[(crc >> 12) ^ (b & 0x0F)]);
+    return crc;
+}
+
+/*****************************************************************************/
+/* crc16()                                                                   */
+/*****************************************************************************/
+uint16_t crc16(const uint8_t *data, size_t size) {
+    uint16_t crc = CRC16_INIT;
+    while (size--)
+        crc = crc16Update(crc, *data++);
+    return crc;
+}
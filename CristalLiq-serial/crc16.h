@@ -0,0 +1,33 @@
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <Arduino.h>
+
+/**
+ * @file crc16.h
+ * @brief CRC-16/CCITT (polinômio 0x1021, valor inicial 0xFFFF, sem reflexão).
+ *
+ * Calculado meio byte por vez com uma tabela de 16 entradas em PROGMEM:
+ * 32 bytes de _flash_ em vez dos 512 da tabela completa.
+ */
+
+#define CRC16_INIT 0xFFFF  /**< Valor inicial do CRC. */
+
+/**
+ * @brief Acrescenta um byte ao CRC em andamento.
+ *
+ * @param crc CRC acumulado (comece com `CRC16_INIT`).
+ * @param b   Próximo byte.
+ * @return CRC atualizado.
+ */
+uint16_t crc16Update(uint16_t crc, uint8_t b);
+
+/**
+ * @brief CRC de um bloco de bytes.
+ *
+ * @param data Bytes.
+ * @param size Quantidade de bytes.
+ */
+uint16_t crc16(const uint8_t *data, size_t size);
+
+#endif // CRC16_H
@@ -0,0 +1,232 @@
+#ifndef DISPLAY_H
+#define DISPLAY_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "frame.h"
+#include "lcdbuffer.h"
+
+/**
+ * @brief Copia um trecho de uma string de origem para um buffer de destino,
+ *        ajustando posição inicial e preenchendo com espaços em branco, se necessário.
+ *
+ * Esta função garante que o conteúdo copiado caiba exatamente no tamanho
+ * do display (ou outro destino), ajustando o índice inicial (`start`) caso:
+ * - A string de origem seja menor ou igual ao destino → começa da posição zero.
+ * - A string de origem seja maior que o destino, mas o ponto inicial da cópia desejada ultrapasse os limites → recua
+ *   o início para preencher completamente o destino.
+ *
+ * Após a cópia, o restante do buffer de destino é preenchido com espaços em branco.
+ * Não há finalizador `'\0'`: o destino costuma ser uma linha de `LcdFrameBuffer`.
+ *
+ * @tparam     SIZE_DEST  Tamanho da string que ficará em `dest`, número de caracteres visíveis no display.
+ * @param[out] dest       Buffer de destino, com pelo menos SIZE_DEST bytes.
+ * @param[in]  origem     String de origem.
+ * @param[in]  sizeOrigem Tamanho da string de origem.
+ * @param[in]  start      Posição inicial na string de origem a partir da qual
+ *                        a cópia deve começar (pode ser ajustada internamente pelo algoritmo).
+ *
+ * @note Com o tamanho do destino conhecido na compilação, o laço tem
+ *       número fixo de voltas.
+ *
+ * @section img_sec2 Exemplo de Funcionamento
+ * \image html img/copiaParcialDeString.png "Detalhamento do Algoritmo"
+ */
+template <byte SIZE_DEST>
+void copiaN(char dest[], const char origem[], byte sizeOrigem, byte start) {
+	//Se a string cabe no display, não pode iniciar impressão para além da posição zero
+	if (sizeOrigem <= SIZE_DEST)
+		start = 0;
+	//E se for maior que o display, recua ao ponto de cópia que preenche completamente o display
+	else if (start > sizeOrigem - SIZE_DEST)
+		start = sizeOrigem - SIZE_DEST;
+
+	for (byte i = 0; i < SIZE_DEST; i++)
+		dest[i] = i < sizeOrigem ? origem[i + start] : ' ';
+}
+
+/**
+ * @def MARQUEE_SEPARATOR
+ * @brief Separa o fim do texto do seu recomeço no modo `SCROLL_MARQUEE`.
+ */
+#ifndef MARQUEE_SEPARATOR
+#define MARQUEE_SEPARATOR " * "
+#endif
+
+/**
+ * @def SCROLL_MAX_STEP_DELAY
+ * @brief Maior `DisplayLine::stepDelay` aceito pelo comando SCROLL.
+ *
+ * Com `SCROLL_EASE` o passo ao lado da pausa dura o dobro, e o dobro
+ * precisa caber num `unsigned int` de 16 bits.
+ */
+#define SCROLL_MAX_STEP_DELAY 32767
+
+/**
+ * @enum ScrollMode
+ * @brief Como rola uma linha maior que a tela.
+ */
+enum ScrollMode {
+	SCROLL_ROLL   = 0x00,  /**< Avança até o fim e volta de uma vez ao início. */
+	SCROLL_BOUNCE = 0x01,  /**< Avança até o fim e volta passo a passo. */
+	SCROLL_MARQUEE = 0x02, /**< Letreiro circular: o texto recomeça logo após `MARQUEE_SEPARATOR`, sem salto. */
+	SCROLL_MOTION = 0x03,  /**< Máscara do tipo de movimento. */
+	SCROLL_EASE   = 0x04   /**< Passos mais lentos perto das pausas, para o movimento começar e terminar suave. */
+};
+
+/**
+ * @struct DisplayLine
+ * @brief Representa o estado de uma linha do display LCD.
+ *
+ * Esta estrutura guarda a mensagem principal e a mensagem padrão, além de
+ * informações de tamanho, posição e tempo de vida (TTL). Os buffers têm
+ * exatamente o tamanho da geometria escolhida. O trecho visível não é
+ * guardado: `render()` o monta direto na linha da tela em RAM.
+ *
+ * Cada linha tem o seu próprio relógio de rolagem (`nextMove`), com
+ * velocidade, pausas e modo independentes das demais.
+ *
+ * @tparam COLS    Colunas do _display_.
+ * @tparam MSG_LEN Maior mensagem aceita (até 255).
+ */
+template <byte COLS, byte MSG_LEN>
+struct DisplayLine {
+	char message[MSG_LEN + 1];        /**< Mensagem atual a ser exibida. */
+	char defaultMessage[MSG_LEN + 1]; /**< Mensagem padrão quando nenhuma outra estiver ativa. */
+	byte messageSize;                 /**< Tamanho da mensagem atual. */
+	byte defaultMessageSize;          /**< Tamanho da mensagem padrão. */
+	byte startPosition;               /**< Posição inicial na mensagem a partir da qual imprime-se no display. */
+	byte scrollMode;                  /**< Um `ScrollMode`, opcionalmente com `SCROLL_EASE`. */
+	bool backwards;                   /**< No modo `SCROLL_BOUNCE`, indica a volta ao início. */
+	bool showingDefault;              /**< A mensagem exibida é a padrão (TTL expirado). */
+	bool redraw;                      /**< O texto mudou e deve ser desenhado desde o início. */
+	unsigned int stepDelay;           /**< Milissegundos entre dois passos da rolagem. */
+	unsigned int pauseStart;          /**< Milissegundos parada no início do texto. */
+	unsigned int pauseEnd;            /**< Milissegundos parada no fim do texto. */
+	unsigned long nextMove;           /**< Instante (`millis()`) do próximo passo da rolagem. */
+	unsigned long TTL;                /**< Tempo de vida da mensagem em milissegundos. Após esse período, retorna à mensagem _default_. */
+
+	/**
+	* @brief Texto exibido no momento: a mensagem ou a padrão.
+	*/
+	const char *text() const { return showingDefault ? defaultMessage : message; }
+
+	/**
+	* @brief Tamanho do texto exibido no momento.
+	*/
+	byte size() const { return showingDefault ? defaultMessageSize : messageSize; }
+
+	/**
+	* @brief Indica se o texto não cabe na linha e precisa rolar.
+	*/
+	bool scrolls() const { return size() > COLS; }
+
+	/**
+	* @brief Volta a rolagem ao início, após a troca do texto.
+	*/
+	void restart() {
+		startPosition = 0;
+		backwards = false;
+		redraw = true;
+	}
+
+	/**
+	* @brief Avança um passo da rolagem.
+	*
+	* @return Milissegundos até o próximo passo: uma das pausas, ao chegar a
+	*         uma ponta, ou `stepDelay` (acrescido perto das pontas, com `SCROLL_EASE`).
+	*/
+	unsigned int advance() {
+		byte last = size() - COLS;
+		if ((scrollMode & SCROLL_MOTION) == SCROLL_MARQUEE) {
+			last = size() + sizeof(MARQUEE_SEPARATOR) - 1;  // Período do letreiro; a única pausa é no recomeço
+			if (++startPosition >= last) {
+				startPosition = 0;
+				return pauseStart;
+			}
+		}
+		else if ((scrollMode & SCROLL_MOTION) == SCROLL_BOUNCE) {
+			if (backwards)
+				startPosition--;
+			else
+				startPosition++;
+			if (startPosition == 0) {
+				backwards = false;
+				return pauseStart;
+			}
+			if (startPosition >= last) {
+				startPosition = last;
+				backwards = true;
+				return pauseEnd;
+			}
+		}
+		else {
+			if (startPosition >= last) {
+				startPosition = 0;
+				return pauseStart;
+			}
+			if (++startPosition == last)
+				return pauseEnd;
+		}
+		unsigned int wait = stepDelay;
+		if (scrollMode & SCROLL_EASE) {
+			byte edge = min(startPosition, (byte) (last - startPosition));
+			if (edge < 8)
+				wait += stepDelay >> edge;  // 1,5x ao lado da pausa, 1,25x a dois passos ...
+		}
+		return wait;
+	}
+
+	/**
+	* @brief Monta o trecho visível do texto, por aritmética de índices e sem cópia intermediária.
+	*
+	* @param[out] dest Exatamente COLS caracteres, sem finalizador.
+	*/
+	void render(char *dest) const {
+		const char *t = text();
+		byte n = size();
+		if ((scrollMode & SCROLL_MOTION) == SCROLL_MARQUEE && n > COLS) {
+			byte k = startPosition;
+			for (byte c = 0; c < COLS; c++) {
+				dest[c] = k < n ? t[k] : MARQUEE_SEPARATOR[k - n];
+				if (++k == n + sizeof(MARQUEE_SEPARATOR) - 1)
+					k = 0;
+			}
+		}
+		else
+			copiaN<COLS>(dest, t, n, startPosition);
+	}
+};
+
+/**
+ * @struct DisplayGeometry
+ * @brief Reúne os tamanhos de um _display_ e os tipos que dependem deles.
+ *
+ * @tparam COLS_    Colunas.
+ * @tparam ROWS_    Linhas (no máximo 8).
+ * @tparam MSG_LEN_ Maior mensagem de uma linha.
+ */
+template <byte COLS_, byte ROWS_, byte MSG_LEN_>
+struct DisplayGeometry {
+	enum {
+		COLS = COLS_,       /**< Colunas do _display_. */
+		ROWS = ROWS_,       /**< Linhas do _display_. */
+		MSG_LEN = MSG_LEN_  /**< Maior mensagem de uma linha. */
+	};
+	typedef DisplayLine<COLS_, MSG_LEN_> Line;          /**< Estado de uma linha. */
+	typedef LcdFrameBuffer<COLS_, ROWS_> FrameBuffer;   /**< Tela em RAM. */
+};
+
+/**
+ * @typedef Geometry
+ * @brief Geometria escolhida em config.h: 16x2, 40x4 ou, por padrão, 20x4.
+ */
+#if defined(LCD_16X2)
+typedef DisplayGeometry<16, 2, MAX_STRING> Geometry;
+#elif defined(LCD_40X4)
+typedef DisplayGeometry<40, 4, MAX_STRING> Geometry;
+#else
+typedef DisplayGeometry<20, 4, MAX_STRING> Geometry;
+#endif
+
+#endif // DISPLAY_H
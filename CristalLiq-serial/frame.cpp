@@ -1,9 +1,13 @@
+#include <util/atomic.h>
 #include "frame.h"
+#include "uart.h"
+#include "latency.h"
 
 // Tabela de conversão para remover acentuação de textos.
 // Infelimente, o display de 4 linhas é limitado e não aceita acentuações da
 // Língua Portuguesa.
-const unsigned char win1252_to_ascii[256] = {
+// Fica em PROGMEM: seriam 256 bytes dos 2 KB de SRAM do Nano.
+const unsigned char win1252_to_ascii[256] PROGMEM = {
     /* 0x00–0x0F */
     0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,
     /* 0x10–0x1F */
@@ -20,10 +24,10 @@ const unsigned char win1252_to_ascii[256] = {
     '`','a','b','c','d','e','f','g','h','i','j','k','l','m','n','o',
     /* 0x70–0x7F */
     'p','q','r','s','t','u','v','w','x','y','z','{','|','}','~',127,
-    /* 0x80–0x8F */
-    128,129,130,131,132,133,134,135,136,137,138,139,140,141,142,143,
+    /* 0x80–0x8F: sinais tipográficos, que o texto em UTF-8 costuma trazer */
+    'E',129,',','f','"','.','+','+','^','%','S','<','O',141,'Z',143,
     /* 0x90–0x9F */
-    144,145,146,147,148,149,150,151,152,153,154,155,156,157,158,159,
+    144,'\'','\'','"','"','*','-','-','~','T','s','>','o',157,'z','Y',
     /* 0xA0–0xAF */
     160,161,162,163,164,165,166,167,168,169,170,171,172,173,174,175,
     /* 0xB0–0xBF */
@@ -41,8 +45,9 @@ const unsigned char win1252_to_ascii[256] = {
 /*****************************************************************************/
 /* Construtor                                                                */
 /*****************************************************************************/
-SerialProtocol::SerialProtocol():machState(START)
+SerialProtocol::SerialProtocol(Stream &stream):machState(START),rxState(START),receivedSize(0),port(&stream),ndx(0),droppedFrames(0),baudRate(DEFAULT_BAUD_RATE),binaryMode(false),checksumMode(false),utf8Mode(false),rxSeq(255),txSeq(0),baudDeadline(0)
 {
+	memset(&counters, 0, sizeof(counters));
 }
 
 /*****************************************************************************/
@@ -55,83 +60,304 @@ SerialProtocol::~SerialProtocol()
 /*****************************************************************************/
 /* setBaudRate()                                                             */
 /*****************************************************************************/
-void SerialProtocol::setBaudRate(int baudRate) {
+void SerialProtocol::setBaudRate(unsigned long baudRate) {
+			this->baudRate = baudRate;
+#ifdef USE_NATIVE_UART
+			uart.begin(baudRate);
+#else
 			Serial.begin(baudRate); // send and receive at 9600 baud
+#endif
+}
+
+/*****************************************************************************/
+/* Taxas aceitas na negociação.                                              */
+/*****************************************************************************/
+static const unsigned long supportedBaudRates[] PROGMEM = {9600, 115200, 250000, 500000, 1000000};
+
+/*****************************************************************************/
+/* isSupportedBaudRate()                                                     */
+/*****************************************************************************/
+bool SerialProtocol::isSupportedBaudRate(unsigned long rate) {
+	for (byte i = 0; i < sizeof(supportedBaudRates) / sizeof(supportedBaudRates[0]); i++) {
+		if (pgm_read_dword(&supportedBaudRates[i]) == rate)
+			return true;
+	}
+	return false;
+}
+
+/*****************************************************************************/
+/* changeBaudRate()                                                          */
+/* O flush() garante que a confirmação saia inteira na taxa antiga.          */
+/*****************************************************************************/
+void SerialProtocol::changeBaudRate(unsigned long rate, unsigned int timeout) {
+	if (rate == baudRate)
+		return;
+	port->flush();
+	setBaudRate(rate);
+	discardInput();
+	if (rate == DEFAULT_BAUD_RATE) {
+		baudDeadline = 0;
+		return;
+	}
+	baudDeadline = millis() + (timeout == 0 ? BAUD_FALLBACK_TIMEOUT : timeout);
+	if (baudDeadline == 0)
+		baudDeadline = 1;
+}
+
+/*****************************************************************************/
+/* discardInput()                                                            */
+/* Descarta o que chegou antes de uma troca de taxa: bytes ainda não lidos,  */
+/* o quadro em montagem e os quadros da fila, que não podem confirmar a taxa */
+/* nova. Com RX_ISR_DECODE a interrupção mexe no mesmo estado.               */
+/*****************************************************************************/
+void SerialProtocol::discardInput() {
+	while (port->available() > 0)
+		port->read();
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		rxState = START;
+		frames.clear();
+	}
 }
 
 /*****************************************************************************/
 /* removeAccentMarker()                                                      */
 /*****************************************************************************/
 void SerialProtocol::removeAccentMarker(char *str) {
-    for (int i = 0; i < strlen(str); i++) {
-        str[i] = win1252_to_ascii[ (unsigned char) str[i] ];
+    for (; *str != '\0'; str++) {
+        *str = accentToAscii(*str);
     }
 }
 
+/*****************************************************************************/
+/* decodeText()                                                              */
+/*****************************************************************************/
+byte SerialProtocol::decodeText(char *str, byte size) {
+    if (!utf8Mode || !(checksumMode || binaryMode))
+        return size;
+    return utf8ToWin1252(str, size);
+}
+
+/*****************************************************************************/
+/* accentToAscii()                                                           */
+/*****************************************************************************/
+char SerialProtocol::accentToAscii(unsigned char c) {
+    return pgm_read_byte(&win1252_to_ascii[c]);
+}
+
+
+/*****************************************************************************/
+/* Tabela de transição da máquina de recepção.                               */
+/* Cada entrada, indexada por [estado][classe do caractere], guarda a ação   */
+/* no nibble alto e o próximo estado no nibble baixo. Fica em PROGMEM para   */
+/* não gastar SRAM.                                                          */
+/*****************************************************************************/
+#define CH_OTHER   0   // Qualquer caractere que não seja de controle
+#define CH_START   1   // '<'
+#define CH_END     2   // '>'
+#define CH_ESCAPE  3   // '\\'
+#define NUM_CLASSES 4
+
+#define ACT_NONE   0x00  // Só muda de estado
+#define ACT_RESET  0x10  // Início de quadro: zera o índice
+#define ACT_STORE  0x20  // Guarda o caractere, se couber no buffer
+#define ACT_FINISH 0x30  // Fim de quadro: termina a string
+#define ACTION_MASK 0xF0
+#define STATE_MASK  0x0F
+
+#define T(action, next) ((action) | SerialProtocol::next)
+
+static const byte transitionTable[SerialProtocol::NUM_STATES][NUM_CLASSES] PROGMEM = {
+	/*                   outro                        '<'                          '>'                          '\\'                       */
+	/* START       */ { T(ACT_NONE,  START),          T(ACT_RESET, RECEIVING),     T(ACT_NONE,   START),        T(ACT_NONE, START)          },
+	/* RECEIVING   */ { T(ACT_STORE, RECEIVING),      T(ACT_RESET, RECEIVING),     T(ACT_FINISH, RECEIVED),     T(ACT_NONE, ESCAPE)         },
+	/* ESCAPE      */ { T(ACT_NONE,  RECEIVING),      T(ACT_STORE, RECEIVING),     T(ACT_STORE,  RECEIVING),    T(ACT_STORE, RECEIVING)     },
+	/* RECEIVED    */ { T(ACT_NONE,  RECEIVED),       T(ACT_NONE,  RECEIVED),      T(ACT_NONE,   RECEIVED),     T(ACT_NONE, RECEIVED)       },
+	/* OVERFLOW    */ { T(ACT_NONE,  OVERFLOW),       T(ACT_RESET, RECEIVING),     T(ACT_NONE,   START),        T(ACT_NONE, OVERFLOW_ESCAPE)},
+	/* OVERFLOW_ESC*/ { T(ACT_NONE,  OVERFLOW),       T(ACT_NONE,  OVERFLOW),      T(ACT_NONE,   OVERFLOW),     T(ACT_NONE, OVERFLOW)       },
+};
+
+/*****************************************************************************/
+/* Classifica o caractere para indexar a tabela de transição.                */
+/*****************************************************************************/
+static inline byte charClass(unsigned char rc) {
+	switch (rc) {
+		case '<':  return CH_START;
+		case '>':  return CH_END;
+		case '\\': return CH_ESCAPE;
+		default:   return CH_OTHER;
+	}
+}
+
+/*****************************************************************************/
+/* store()                                                                   */
+/* Guarda um caractere do conteúdo, se couber no buffer.                     */
+/*****************************************************************************/
+static inline void store(byte &state, byte &index, char *buf, char c)
+{
+	if (index < MAX_PROTOCOL_MESSAGE)
+		buf[index++] = c;
+	else
+		state = SerialProtocol::OVERFLOW;
+}
+
+/*****************************************************************************/
+/* decode()                                                                  */
+/* Um caractere que não cabe no buffer leva a OVERFLOW: o restante do        */
+/* quadro é descartado até o '>' final, ou até um novo '<'.                  */
+/* O buffer precisa ter MAX_PROTOCOL_MESSAGE+1 bytes.                        */
+/* Com utf8, o que é guardado já é o caractere Windows-1252. Os '<', '>' e   */
+/* '\' são ASCII e nunca aparecem dentro de uma sequência UTF-8; uma         */
+/* sequência cortada pelo '>' final vira UTF8_REPLACEMENT.                   */
+/*****************************************************************************/
+void SerialProtocol::decode(byte &state, byte &index, char *buf, unsigned char rc, Utf8Decoder *utf8)
+{
+	byte t = pgm_read_byte(&transitionTable[state][charClass(rc)]);
+	state = t & STATE_MASK;
+	switch (t & ACTION_MASK) {
+		case ACT_RESET:
+		  index = 0;
+		  if (utf8 != NULL)
+			  utf8->reset();
+		  break;
+		case ACT_STORE:
+		  if (utf8 == NULL)
+			  store(state, index, buf, rc);
+		  else {
+			  char out[2];
+			  byte n = utf8->decode(rc, out);
+			  for (byte i = 0; i < n; i++)
+				  store(state, index, buf, out[i]);
+		  }
+		  break;
+		case ACT_FINISH:
+		  if (utf8 != NULL && utf8->incomplete()) {
+			  if (index == MAX_PROTOCOL_MESSAGE) {
+				  state = START;      // Não cabe: descartado como em OVERFLOW
+				  break;
+			  }
+			  buf[index++] = UTF8_REPLACEMENT;
+		  }
+		  buf[index] = '\0';  // index fica com o tamanho do quadro até o próximo '<'
+		  break;
+	}
+}
+
+/*****************************************************************************/
+/* decodeByte()                                                              */
+/* O quadro é montado na posição livre da fila; se a fila estiver cheia ao   */
+/* final, o quadro é perdido e a mesma posição é reaproveitada.              */
+/* Com CRC (texto ou binário) os bytes são guardados como vieram.            */
+/* Os contadores vêm da comparação entre o estado anterior e o novo: de      */
+/* START para START é um byte fora de quadro; de RECEIVING para OVERFLOW, ou */
+/* para START no '>' (UTF-8 cortado sem espaço), um quadro grande demais.    */
+/*****************************************************************************/
+void SerialProtocol::decodeByte(unsigned char rc)
+{
+	Frame *f = frames.slot();
+	byte previous = rxState;
+	decode(rxState, ndx, f->data, rc, utf8Mode && !checksumMode && !binaryMode ? &utf8 : NULL);
+	switch (rxState) {
+		case RECEIVED:
+			f->size = ndx;
+#ifdef LATENCY_STATS
+			f->stamp = LATENCY_STAMP();
+#endif
+			counters.framesReceived++;
+			if (!frames.commit())
+				droppedFrames++;
+			rxState = START;
+			break;
+		case START:
+			if (previous == START)
+				counters.discardedBytes++;
+			else if (previous == RECEIVING)
+				counters.oversizeFrames++;
+			break;
+		case OVERFLOW:
+			if (previous == RECEIVING || previous == ESCAPE)
+				counters.oversizeFrames++;
+			break;
+		case RECEIVING:
+			if (previous == ESCAPE && charClass(rc) == CH_OTHER)
+				counters.escapeErrors++;
+			break;
+	}
+}
+
+/*****************************************************************************/
+/* nextFrame()                                                               */
+/*****************************************************************************/
+bool SerialProtocol::nextFrame()
+{
+	Frame *f = frames.front();
+	if (f == NULL) {
+		machState = START;
+		return false;
+	}
+	memcpy(receivedChars, f->data, sizeof(receivedChars));
+	receivedSize = f->size;
+#ifdef LATENCY_STATS
+	receivedStamp = f->stamp;
+#endif
+	frames.drop();
+	machState = RECEIVED;
+	baudDeadline = 0;  // Um quadro válido confirma a taxa atual; os anteriores à troca foram descartados
+	return true;
+}
 
 /*****************************************************************************/
 /* Não há timeout na função Serial.read().                                   */
 /* Para contornar a limitação, a recepção de um frame completo pode envolver */
-/* várias invocações desta função, daí as variáveis ndx e recvInProgress     */
-/* serem estáticas.                                                          */
+/* várias invocações desta função, daí o estado e o índice ndx ficarem na    */
+/* instância.                                                                */
 /* no loop() do Arduino, continuará invocando esta função até que o frame    */
 /* se complete.                                                              */
+/* Com RX_ISR_DECODE a interrupção já montou os quadros; basta pegar o mais  */
+/* antigo.                                                                   */
+/* Também é aqui que expira o prazo de uma troca de taxa não confirmada.     */
 /*****************************************************************************/
 void SerialProtocol::receiveFrame() 
 {
-	static byte ndx = 0;
-	unsigned char rc;
-	while (Serial.available() > 0 && machState != RECEIVED) {
-        rc = Serial.read();
-		switch (machState) {
-		   case START:
-		     switch (rc) {
-			    case '<':
-				  ndx = 0;
-				  machState = RECEIVING;
-				  break;
-				default:
-				  machState = START;
-				  break;
-			 }
-		     break;
-		   case RECEIVING:
-		     switch (rc) {
-				case '<':
-				  ndx = 0;
-				  machState = RECEIVING;
-				  break;
-			    case '>':
-				  machState = RECEIVED;
-				  receivedChars[ndx] = '\0';
-				  ndx = 0;
-				  break;
-			    case '\\':
-				  machState = ESCAPE;
-				  break;
-				default:
-				  machState = RECEIVING;
-				  receivedChars[ndx++] = rc;
-				  break;
-			 }
-		     break;
-		   case ESCAPE:
-		     switch (rc) {
-			    case '>':
-				case '\\':
-				case '<':
-				  machState = RECEIVING;
-				  receivedChars[ndx++] = rc;
-				  break;
-				default:
-				  machState = RECEIVING;
-				  break;
-			 }
-		     break;
-		   case RECEIVED:
-		     // Não ocorre...
-		     break;
-		}
+	if (baudDeadline != 0 && (long) (millis() - baudDeadline) >= 0) {
+		baudDeadline = 0;
+		setBaudRate(DEFAULT_BAUD_RATE);
+		discardInput();
+		binaryMode = false;
+		checksumMode = false;
+		utf8Mode = false;
+	}
+#ifndef RX_ISR_DECODE
+#ifndef USE_NATIVE_UART
+	if (port == &Serial && port->available() >= SERIAL_RX_BUFFER_SIZE - 1)
+		counters.rxOverruns++;  // Cheio: a Serial descarta o que chegar sem avisar
+#endif
+	while (port->available() > 0 && !frames.full()) {
+		decodeByte(port->read());
+	}
+#endif
+	if (machState != RECEIVED)
+		nextFrame();
+}
+
+/*****************************************************************************/
+/* inputPending()                                                            */
+/*****************************************************************************/
+bool SerialProtocol::inputPending()
+{
+	return !frames.empty() || port->available() > 0;
+}
+
+/*****************************************************************************/
+/* snapshot()                                                                */
+/*****************************************************************************/
+void SerialProtocol::snapshot(Counters &out)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		out = counters;
+		out.droppedFrames = droppedFrames;
+#ifdef USE_NATIVE_UART
+		out.rxOverruns = uart.rxOverruns;
+#endif
 	}
 }
 
@@ -139,26 +365,212 @@ void SerialProtocol::receiveFrame()
 /* Uma mensagem é inserida num frame.                                        */
 /* Algo como, "mensagem" vira "<mensagem>".                                  */
 /* Se a mensagem contiver '>', '<', ou '\', deve ficar com '\' antecedendo.  */
-/* Também há uma limitação importante, não se pode ultrapassar o tamanho     */
-/* máximo do buffer alocado, MAX_PROTOCOL_MESSAGE+1.                         */
+/* Também há uma limitação importante, o quadro não pode ultrapassar         */
+/* MAX_PROTOCOL_MESSAGE+1 bytes. Um caractere escapado que não caiba junto   */
+/* com o seu '\' fica de fora, para não escapar o '>' final.                 */
+/* Com checksumMode, o "|SEQ|CRC" vai além desse limite.                     */
 /*****************************************************************************/
-void SerialProtocol::sendFrame(char* message) {
-	int i = 0;
-	sendChars[i++] = '<';
+size_t SerialProtocol::sendFrame(const char* message) {
+	size_t i = 0;
+	uint16_t crc = CRC16_INIT;
+#ifdef LATENCY_STATS
+	latency.reply();
+#endif
+	counters.framesSent++;
+	i += port->write('<');
 	while( *message != '\0' && i < (MAX_PROTOCOL_MESSAGE - 1) ) {
-		switch (*message) {
-			case '<':
-			case '>':
-			case '\\':
-			  sendChars[i++] = '\\';
-			  if (i == MAX_PROTOCOL_MESSAGE - 1) //Trunca a mensagem, pois só cabe o '>' e '\0' finalizador.
-				  continue;			             //Não faz break, pois quer copiar o caractere seguinte em toda situação	  
-			default:
-			  sendChars[i++] = *message++;	
-              break;			  
+		char c = *message++;
+		if (c == '<' || c == '>' || c == '\\') {
+			if (i + 1 == MAX_PROTOCOL_MESSAGE - 1) //Trunca a mensagem, pois só cabe o '>' final.
+				break;
+			i += port->write('\\');
 		}
+		i += port->write(c);
+		crc = crc16Update(crc, c);
+	}
+	if (checksumMode)
+		i += writeTrailer(crc);
+	i += port->write('>');
+	return i;
+}
+
+/*****************************************************************************/
+/* writeTrailer()                                                            */
+/* Acrescenta "|SEQ|CRC". O CRC cobre a mensagem e o "|SEQ", sem escapes, e  */
+/* vai em 4 dígitos hexadecimais.                                            */
+/*****************************************************************************/
+size_t SerialProtocol::writeTrailer(uint16_t crc) {
+	static const char hexDigits[] PROGMEM = "0123456789ABCDEF";
+	char field[4];
+	size_t n = 0;
+	utoa(txSeq, field, 10);
+	crc = crc16Update(crc, '|');
+	n += port->write('|');
+	for (char *p = field; *p != '\0'; p++) {
+		crc = crc16Update(crc, *p);
+		n += port->write(*p);
+	}
+	n += port->write('|');
+	for (int shift = 12; shift >= 0; shift -= 4)
+		n += port->write(pgm_read_byte(&hexDigits[(crc >> shift) & 0x0F]));
+	return n;
+}
+
+/*****************************************************************************/
+/* verifyTrailer()                                                           */
+/* Confere o CRC de "code|msg|TTL|SEQ|CRC" e corta o "|SEQ|CRC" do fim. O    */
+/* CRC tem exatamente 4 dígitos hexadecimais, e o SEQ de 1 a 3 dígitos       */
+/* decimais, até 255; qualquer outra coisa recusa o quadro.                  */
+/*****************************************************************************/
+bool SerialProtocol::verifyTrailer() {
+	char *crcField = strrchr(receivedChars, '|');
+	if (crcField == NULL || strlen(crcField + 1) != 4)
+		return false;
+	uint16_t crc = 0;
+	for (char *p = crcField + 1; *p != '\0'; p++) {
+		byte digit;
+		if (*p >= '0' && *p <= '9')
+			digit = *p - '0';
+		else if (*p >= 'A' && *p <= 'F')
+			digit = *p - 'A' + 10;
+		else if (*p >= 'a' && *p <= 'f')
+			digit = *p - 'a' + 10;
+		else
+			return false;
+		crc = (crc << 4) | digit;
+	}
+	if (crc16((const uint8_t *) receivedChars, crcField - receivedChars) != crc)
+		return false;
+	*crcField = '\0';
+	char *seqField = strrchr(receivedChars, '|');
+	if (seqField == NULL)
+		return false;
+	byte digits = crcField - seqField - 1;
+	unsigned int seq = 0;
+	if (digits < 1 || digits > 3)
+		return false;
+	for (char *p = seqField + 1; p < crcField; p++) {
+		if (*p < '0' || *p > '9')
+			return false;
+		seq = seq * 10 + (*p - '0');
+	}
+	if (seq > 255)
+		return false;
+	rxSeq = seq;
+	txSeq = rxSeq;
+	*seqField = '\0';
+	return true;
+}
+
+/*****************************************************************************/
+/* sendNak()                                                                 */
+/* O número pedido é o seguinte ao último quadro íntegro: o que chegou       */
+/* corrompido pode ter o próprio número de sequência danificado.             */
+/*****************************************************************************/
+void SerialProtocol::sendNak() {
+	char reply[9];  // "005|255|"
+	byte expected = rxSeq + 1;
+	if (binaryMode) {
+		sendBinary(5, 0, "");
+		return;
+	}
+	txSeq = expected;
+	strcpy(reply, "005|");
+	utoa(expected, reply + 4, 10);
+	strcat(reply, "|");
+	sendFrame(reply);
+}
+
+/*****************************************************************************/
+/* pendingOutput()                                                           */
+/*****************************************************************************/
+int SerialProtocol::pendingOutput() {
+#ifdef USE_NATIVE_UART
+	return uart.pending();
+#else
+	return SERIAL_TX_BUFFER_SIZE - 1 - port->availableForWrite();
+#endif
+}
+
+/*****************************************************************************/
+/* writeEscaped()                                                            */
+/* Escreve um byte do conteúdo do quadro, escapando '<', '>' e '\'.          */
+/*****************************************************************************/
+size_t SerialProtocol::writeEscaped(byte c) {
+	size_t n = 0;
+	if (c == '<' || c == '>' || c == '\\')
+		n += port->write('\\');
+	return n + port->write(c);
+}
+
+/*****************************************************************************/
+/* parseBinary()                                                             */
+/* O varint é little-endian em grupos de 7 bits; o bit 7 indica que há mais  */
+/* um byte.                                                                  */
+/*****************************************************************************/
+bool SerialProtocol::parseBinary(int &code, int &ttl, char *&message, byte &size) {
+	const byte *p = (const byte *) receivedChars;
+	byte end = receivedSize - 2;  // Início do CRC
+	if (receivedSize < 5)         // opcode + varint + tamanho + CRC
+		return false;
+	if (crc16(p, end) != (uint16_t) ((p[end] << 8) | p[end + 1]))
+		return false;
+
+	byte pos = 1;
+	byte shift = 0;
+	unsigned long value = 0;
+	do {
+		if (pos >= end || shift > 28)
+			return false;
+		value |= (unsigned long) (p[pos] & 0x7F) << shift;
+		shift += 7;
+	} while (p[pos++] & 0x80);
+
+	if (pos >= end)
+		return false;
+	byte len = p[pos++];
+	if (len > MAX_STRING || pos + len != end)
+		return false;
+
+	code = (p[0] >> 4) * 100 + (p[0] & 0x0F);
+	ttl = value > 32767 ? 32767 : (int) value;
+	message = receivedChars + pos;
+	message[len] = '\0';  // Sobre o CRC, que já foi conferido
+	size = len;
+	return true;
+}
+
+/*****************************************************************************/
+/* sendBinary()                                                              */
+/* O CRC é calculado sobre os bytes sem escape, à medida que são escritos.   */
+/*****************************************************************************/
+size_t SerialProtocol::sendBinary(int code, unsigned long value, const char *payload) {
+	uint16_t crc = CRC16_INIT;
+	byte len = strnlen(payload, MAX_STRING);
+	byte b = ((code / 100) << 4) | (code % 100);
+#ifdef LATENCY_STATS
+	latency.reply();
+#endif
+	counters.framesSent++;
+	size_t n = port->write('<');
+
+	crc = crc16Update(crc, b);
+	n += writeEscaped(b);
+	do {
+		b = value & 0x7F;
+		value >>= 7;
+		if (value != 0)
+			b |= 0x80;
+		crc = crc16Update(crc, b);
+		n += writeEscaped(b);
+	} while (value != 0);
+	crc = crc16Update(crc, len);
+	n += writeEscaped(len);
+	for (byte i = 0; i < len; i++) {
+		crc = crc16Update(crc, payload[i]);
+		n += writeEscaped(payload[i]);
 	}
-	sendChars[i++] = '>';
-	sendChars[i]   = '\0';
-	Serial.write(sendChars);
-}
\ No newline at end of file
+	n += writeEscaped(crc >> 8);
+	n += writeEscaped(crc & 0xFF);
+	return n + port->write('>');
+}
@@ -2,8 +2,15 @@
 #define FRAME_H
 
 #include <Arduino.h>
+#include "config.h"
+#include "ringbuffer.h"
+#include "crc16.h"
+#include "utf8.h"
 #define MAX_STRING    50
-#define MAX_PROTOCOL_MESSAGE  MAX_STRING + 4  // ddd,maior string já desprezados os caracteres de inicio e fim '<' e '>'
+#define CHECKSUM_TRAILER_SIZE 9  // "|SEQ|CRC" mais longo do modo com CRC: "|255|FFFF"
+#define MAX_PROTOCOL_MESSAGE  (MAX_STRING + 4 + CHECKSUM_TRAILER_SIZE)  // ddd,maior string e o "|SEQ|CRC", já desprezados os caracteres de inicio e fim '<' e '>'
+#define DEFAULT_BAUD_RATE      9600UL  // Taxa inicial e de recuperação da serial
+#define BAUD_FALLBACK_TIMEOUT  2000    // Milissegundos para chegar um quadro válido na nova taxa
 
 /**
  * @class SerialProtocol
@@ -13,10 +20,12 @@
  * - Receber e montar mensagens do tipo `<codigo,mensagem,TTL>`.
  * - Enviar mensagens serializadas para a TV-Box.
  * - Remover caracteres de acento que podem interferir na comunicação.
+ * - Converter o texto recebido em UTF-8 para Windows-1252, quando a sessão pede.
  * - Configurar a taxa de transmissão serial.
  *
- * @note O buffer `receivedChars` armazena a mensagem recebida,
- *       `sendChars` armazena a mensagem a ser enviada.
+ * @note O buffer `receivedChars` armazena a mensagem recebida. Os quadros que
+ *       chegam em rajada esperam na fila `frames`. Na transmissão não há
+ *       buffer intermediário: o quadro vai direto para a fila de saída do `port`.
  *
  * @section img_sec Máquina de Estado do protocolo
  * \image html img/MaquinaEstadoProtocolo.png "Máquina de Estados"
@@ -26,51 +35,310 @@ class SerialProtocol {
     /**
     * @enum machineState
     * @brief Estados possíveis da máquina de recepção de frames.
+    *
+    * `OVERFLOW` e `OVERFLOW_ESCAPE` descartam um quadro maior que
+    * `MAX_PROTOCOL_MESSAGE` até o seu '>' final (ou até um novo '<').
     */
-    enum machineState {START, RECEIVING, ESCAPE, RECEIVED};
+    enum machineState {START, RECEIVING, ESCAPE, RECEIVED, OVERFLOW, OVERFLOW_ESCAPE, NUM_STATES};
 
 		/**
-		* @brief Estado atual da máquina de recepção.
+		* @brief Indica se há um quadro pronto em `receivedChars`.
+		*
+		* Vale `RECEIVED` enquanto o quadro atual não foi consumido e `START`
+		* quando não há quadro. O estado interno da máquina de recepção fica
+		* em `rxState`.
 		*/
 		byte machState;
 
+		/**
+		* @brief Estado atual da máquina de recepção.
+		*/
+		byte rxState;
+
 		/**
 		* @brief Buffer para armazenar a mensagem recebida.
 		*/
 		char receivedChars[MAX_PROTOCOL_MESSAGE+1];
 
 		/**
-		* @brief Buffer para armazenar a mensagem a ser enviada.
+		* @brief Quantidade de bytes do quadro em `receivedChars`.
+		*
+		* Necessário no modo binário, em que o conteúdo pode ter bytes nulos.
+		*/
+		byte receivedSize;
+
+#ifdef LATENCY_STATS
+		/**
+		* @brief Instante em que o quadro de `receivedChars` terminou de chegar.
+		*/
+		uint16_t receivedStamp;
+#endif
+
+		/**
+		* @brief Canal de onde os quadros são lidos e para onde são escritos.
+		*
+		* Por padrão é a `Serial` de hardware, mas qualquer `Stream` serve
+		* (SoftwareSerial, um buffer em memória para medições etc.).
+		*/
+		Stream *port;
+
+		/**
+		* @brief Próxima posição livre no quadro em montagem.
+		*/
+		byte ndx;
+
+		/**
+		* @brief Quadro completo, como fica na fila de recepção.
+		*/
+		struct Frame {
+			char data[MAX_PROTOCOL_MESSAGE+1]; /**< Conteúdo do quadro, já sem delimitadores e escapes. */
+			byte size;                         /**< Quantidade de bytes em `data`. */
+#ifdef LATENCY_STATS
+			uint16_t stamp;                    /**< Instante do '>' final (`LATENCY_STAMP()`). */
+#endif
+		};
+
+		/**
+		* @brief Quadros completos ainda não consumidos pelo `loop()`.
+		*
+		* Estática, com `FRAME_QUEUE_SIZE` posições. O quadro em recepção é
+		* montado diretamente na posição livre da fila. Com `RX_ISR_DECODE`
+		* quem a preenche é a interrupção de RX.
+		*/
+		RingBuffer<Frame, FRAME_QUEUE_SIZE> frames;
+
+		/**
+		* @brief Quadros completos descartados por fila cheia.
+		*/
+		volatile unsigned int droppedFrames;
+
+		/**
+		* @brief Contadores de saúde da comunicação, desde o reset.
+		*
+		* Servem para a TV-Box perceber uma placa que começa a perder quadros
+		* antes que as atualizações do display falhem.
+		*/
+		struct Counters {
+			unsigned long framesReceived;  /**< Quadros completos recebidos, inclusive os perdidos por fila cheia. */
+			unsigned long framesSent;      /**< Quadros enviados, de texto ou binários. */
+			unsigned long discardedBytes;  /**< Bytes fora de quadro (estado `START`), descartados até o próximo '<'. */
+			unsigned int escapeErrors;     /**< '\\' seguido de um caractere que não precisa de escape; os dois são descartados. */
+			unsigned int oversizeFrames;   /**< Quadros que não couberam em `MAX_PROTOCOL_MESSAGE` e foram descartados. */
+			unsigned int rxOverruns;       /**< Bytes perdidos antes de chegar à máquina de recepção (ver `snapshot()`). */
+			unsigned int droppedFrames;    /**< Cópia de `SerialProtocol::droppedFrames`, preenchida por `snapshot()`. */
+		};
+
+		/**
+		* @brief Contadores atualizados pela recepção e pela transmissão.
+		*
+		* Com `RX_ISR_DECODE` os da recepção mudam dentro da interrupção;
+		* leia-os com `snapshot()`.
 		*/
-		char sendChars[MAX_PROTOCOL_MESSAGE+1];
+		Counters counters;
+
+		/**
+		* @brief Taxa em bauds configurada no momento.
+		*/
+		unsigned long baudRate;
+
+		/**
+		* @brief Sessão em modo binário compacto em vez do texto `<code|msg|TTL>`.
+		*
+		* Começa desligado e volta a desligar quando a taxa cai para
+		* `DEFAULT_BAUD_RATE` por falta de confirmação.
+		*
+		* @see parseBinary
+		* @see sendBinary
+		*/
+		bool binaryMode;
+
+		/**
+		* @brief Sessão com número de sequência e CRC-16 nos quadros de texto.
+		*
+		* Os quadros passam a ser `<code|msg|TTL|SEQ|CRC>`, com SEQ de 0 a 255
+		* e o CRC-16/CCITT em 4 dígitos hexadecimais, calculado sobre
+		* `code|msg|TTL|SEQ` sem os escapes. As respostas repetem o SEQ do
+		* comando e recebem o trailer depois do último campo, mesmo vazio
+		* (`<002|OK||7|7F46>`). Desliga junto com `binaryMode`.
+		*
+		* O trailer não diminui a mensagem: `receivedChars` e a fila de quadros
+		* têm `CHECKSUM_TRAILER_SIZE` bytes a mais para ele.
+		*
+		* @see verifyTrailer
+		* @see sendNak
+		*/
+		bool checksumMode;
+
+		/**
+		* @brief Sessão em que a TV-Box envia o texto em UTF-8 em vez de Windows-1252.
+		*
+		* Nos quadros de texto sem CRC a conversão é feita pela máquina de
+		* recepção, byte a byte: `receivedChars` já chega em Windows-1252 e
+		* um acento ocupa um só byte dos `MAX_PROTOCOL_MESSAGE`. Com
+		* `checksumMode` ou `binaryMode` o CRC cobre os bytes originais, então
+		* o quadro é guardado como veio e convertido por `decodeText()` depois
+		* de conferido. Vale para os quadros recebidos depois da confirmação
+		* do comando que o liga. Desliga junto com `binaryMode`.
+		*/
+		bool utf8Mode;
+
+		/**
+		* @brief Número de sequência do último quadro recebido íntegro.
+		*/
+		byte rxSeq;
+
+		/**
+		* @brief Número de sequência posto nos quadros enviados.
+		*/
+		byte txSeq;
 		
 		/**
 		* @brief Construtor padrão da classe SerialProtocol.
 		*
 		* Inicializa os buffers e coloca a máquina em estado START.
+		*
+		* @param stream Canal usado na recepção e transmissão dos quadros.
 		*/
-		SerialProtocol();/**
+		SerialProtocol(Stream &stream = Serial);/**
 		* @brief Destrutor virtual.
 		*
 		* Permite que classes derivadas possam sobrescrever o destrutor.
 		*/
 		virtual ~SerialProtocol();
 		/**
-		* @brief Recebe um frame da TV-Box e atualiza o buffer `receivedChars`.
+		* @brief Recebe os quadros da TV-Box e entrega o mais antigo em `receivedChars`.
 		*
 		* A máquina de estados interpreta os caracteres de início/fim, '<' e '>'
-		* e caracteres de escape'\<', '\>'e '\\'.
+		* e caracteres de escape'\<', '\>'e '\\'. Todos os bytes disponíveis
+		* são decodificados de uma vez, enquanto houver espaço na fila `frames`;
+		* o que não couber fica no buffer da serial para a próxima chamada.
+		*
+		* Se não havia quadro pendente, o mais antigo da fila é copiado para
+		* `receivedChars` e `machState` passa a `RECEIVED`.
 		*
 		* @see machState
+		* @see nextFrame
 		*/
 		void receiveFrame();
 		/**
+		* @brief Descarta o quadro atual e entrega o próximo da fila, se houver.
+		*
+		* Permite ao `loop()` tratar uma rajada de comandos numa só passada.
+		*
+		* @return `true` se um novo quadro foi posto em `receivedChars`.
+		*/
+		bool nextFrame();
+		/**
+		* @brief Indica se há bytes à espera de decodificação ou quadros na fila.
+		*
+		* Serve para acordar quem chama `receiveFrame()` só quando há o que receber.
+		*/
+		bool inputPending();
+		/**
+		* @brief Copia `counters` sem o risco de a interrupção de RX alterá-los no meio.
+		*
+		* Com `USE_NATIVE_UART`, `rxOverruns` vem de `NativeUart::rxOverruns`:
+		* estouros do registrador da USART e da fila `rx`. Com a `Serial` do
+		* núcleo Arduino, que descarta os bytes sem contar, é o número de vezes
+		* em que `receiveFrame()` encontrou o buffer de recepção cheio, quando
+		* os bytes seguintes podem ter sido perdidos.
+		*
+		* @param[out] out Cópia dos contadores.
+		*/
+		void snapshot(Counters &out);
+		/**
+		* @brief Passa um caractere pela máquina de recepção.
+		*
+		* A transição é uma consulta à tabela em PROGMEM indexada pelo estado
+		* atual e pela classe do caractere ('<', '>', '\\' ou outro). Nunca
+		* escreve além do quadro em montagem. Ao encontrar o '>' final, publica
+		* o quadro em `frames` (ou o descarta, se a fila estiver cheia).
+		*
+		* Com `RX_ISR_DECODE` é chamada pela interrupção de RX.
+		*
+		* @param rc Caractere recebido.
+		*/
+		void decodeByte(unsigned char rc);
+		/**
 		* @brief Envia uma mensagem via serial para a TV-Box.
 		*
+		* Os delimitadores e escapes são acrescentados à medida que os bytes
+		* são escritos no `port`. Com `USE_NATIVE_UART`, só espera a linha se a
+		* fila de transmissão encher.
+		*
 		* @param message Mensagem a ser enviada. Deve estar formatada
 		*                de acordo com as regras de framing e de alguma semântica de mensagem. No IFSPresente é `<codigo,mensagem,TTL>`.
+		* @return Quantidade de bytes do quadro entregues ao `port`.
+		*/
+		size_t sendFrame(const char* message);
+		/**
+		* @brief Bytes já entregues ao `port` que ainda aguardam a linha serial.
+		*
+		* Permite ao `loop()` adiar trabalho não urgente enquanto a resposta sai.
 		*/
-		void sendFrame(char* message);
+		int pendingOutput();
+		/**
+		* @brief Decodifica o quadro binário que está em `receivedChars`.
+		*
+		* Formato (antes dos delimitadores e escapes, iguais aos do texto):
+		* `opcode | TTL em varint | tamanho | mensagem | CRC-16 (2 bytes, MSB primeiro)`.
+		* O opcode é a centena do código no nibble alto e o resto no nibble
+		* baixo (500 &rarr; 0x50, 701 &rarr; 0x71). O CRC-16/CCITT cobre do
+		* opcode ao fim da mensagem.
+		*
+		* Todos os campos estão em posições conhecidas, sem `strtok` nem `atoi`,
+		* e a mensagem não é copiada.
+		*
+		* @param[out] code    Código da mensagem.
+		* @param[out] ttl     Tempo de vida, limitado a 32767 ms.
+		* @param[out] message Aponta para a mensagem dentro de `receivedChars`, terminada em '\0'.
+		* @param[out] size    Tamanho da mensagem.
+		* @return `false` se o tamanho ou o CRC não conferem.
+		*/
+		bool parseBinary(int &code, int &ttl, char *&message, byte &size);
+		/**
+		* @brief Envia uma mensagem no formato binário compacto.
+		*
+		* @param code    Código da mensagem (a dezena/unidade precisa ser menor que 16).
+		* @param value   Campo numérico (varint).
+		* @param payload Texto da mensagem, truncado em `MAX_STRING` caracteres.
+		* @return Quantidade de bytes do quadro entregues ao `port`.
+		*
+		* @see parseBinary
+		*/
+		size_t sendBinary(int code, unsigned long value, const char *payload);
+		/**
+		* @brief Confere e retira o `|SEQ|CRC` do fim de `receivedChars`.
+		*
+		* Deve ser chamada antes de qualquer alteração no quadro (como a
+		* remoção de acentos). Em caso de sucesso, `rxSeq` e `txSeq` passam a
+		* ser o SEQ do quadro e `receivedChars` fica como `code|msg|TTL`.
+		*
+		* @return `false` se o CRC não confere, faltam campos ou o CRC não tem
+		*         exatamente 4 dígitos hexadecimais e o SEQ de 1 a 3 dígitos
+		*         decimais, até 255.
+		*/
+		bool verifyTrailer();
+		/**
+		* @brief Pede a retransmissão de um quadro corrompido.
+		*
+		* Envia `<005|SEQ|>` com o SEQ seguinte ao último quadro íntegro, para a
+		* TV-Box repetir só esse quadro. No modo binário, que não tem número de
+		* sequência, envia a resposta 005 com valor 0.
+		*/
+		void sendNak();
+		/**
+		* @brief Converte para Windows-1252 um texto que chegou em UTF-8 sem passar pela recepção.
+		*
+		* Só faz algo com `utf8Mode` e `checksumMode` ou `binaryMode`, em que a
+		* máquina de recepção guarda os bytes como vieram. Deve ser chamada
+		* depois de `verifyTrailer()` ou `parseBinary()`.
+		*
+		* @param str  Texto, convertido no lugar e terminado em `'\0'`.
+		* @param size Quantidade de bytes em `str`.
+		* @return Tamanho do texto convertido.
+		*/
+		byte decodeText(char *str, byte size);
 		/**
 		* @brief Remove acentos e caracteres especiais de uma string.
 		*
@@ -80,11 +348,52 @@ class SerialProtocol {
 		*/
 		void removeAccentMarker(char* str);
 		/**
+		* @brief Converte um caractere Windows-1252 acentuado no equivalente sem acento.
+		*
+		* Permite remover os acentos durante outra passada pela string.
+		*
+		* @param c Caractere.
+		*/
+		static char accentToAscii(unsigned char c);
+		/**
 		* @brief Configura a taxa de transmissão serial.
 		*
+		* Só tem efeito sobre a `Serial` de hardware (ou a NativeUart, com
+		* `USE_NATIVE_UART`); outros canais devem ser configurados por quem os criou.
+		*
 		* @param baudRate Taxa em bauds (ex.: 9600, 115200).
 		*/
-		void setBaudRate(int baudRate);
+		void setBaudRate(unsigned long baudRate);
+		/**
+		* @brief Indica se a taxa pode ser negociada com a TV-Box.
+		*
+		* São aceitas 9600, 115200, 250000, 500000 e 1000000 bauds; as três
+		* últimas são exatas com o cristal de 16 MHz.
+		*
+		* @param rate Taxa em bauds.
+		*/
+		bool isSupportedBaudRate(unsigned long rate);
+		/**
+		* @brief Troca a taxa da serial após a confirmação ter sido transmitida.
+		*
+		* Espera a saída esvaziar, reconfigura a porta e descarta tudo o que
+		* chegou na taxa anterior: os bytes ainda não lidos, o quadro que estava
+		* sendo montado e os quadros da fila. Assim só um quadro recebido depois
+		* da troca a confirma. Se nenhum chegar na nova taxa em `timeout`
+		* milissegundos, `receiveFrame()` volta para `DEFAULT_BAUD_RATE`.
+		*
+		* @param rate    Nova taxa em bauds.
+		* @param timeout Prazo para a confirmação; 0 usa `BAUD_FALLBACK_TIMEOUT`.
+		*/
+		void changeBaudRate(unsigned long rate, unsigned int timeout);
+
+	private:
+		unsigned long baudDeadline;  // Instante limite para confirmar a nova taxa; 0 se não há troca pendente
+		Utf8Decoder utf8;            // Sequência UTF-8 em andamento no quadro em recepção
+		void discardInput();
+		size_t writeEscaped(byte c);
+		size_t writeTrailer(uint16_t crc);
+		static void decode(byte &state, byte &index, char *buf, unsigned char rc, Utf8Decoder *utf8);
 };
 
 #endif // FRAME_H
\ No newline at end of file
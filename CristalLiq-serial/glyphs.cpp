@@ -0,0 +1,108 @@
+#include "glyphs.h"
+
+#ifdef LCD_ACCENTS
+
+#include "frame.h"
+
+/*****************************************************************************/
+/* Letras com desenho, em Windows-1252, e os desenhos na mesma ordem.        */
+/*****************************************************************************/
+static const byte glyphChars[] PROGMEM = {
+	0xE0, 0xE1, 0xE2, 0xE3, 0xE7, 0xE9, 0xEA, 0xED, 0xF3, 0xF4, 0xF5, 0xFA, 0xFC,  // à á â ã ç é ê í ó ô õ ú ü
+	0xC0, 0xC1, 0xC2, 0xC3, 0xC7, 0xC9, 0xCA, 0xCD, 0xD3, 0xD4, 0xD5, 0xDA         // À Á Â Ã Ç É Ê Í Ó Ô Õ Ú
+};
+
+static const byte glyphBitmaps[][8] PROGMEM = {
+	{0x08, 0x04, 0x0E, 0x01, 0x0F, 0x11, 0x0F, 0x00},  // à
+	{0x02, 0x04, 0x0E, 0x01, 0x0F, 0x11, 0x0F, 0x00},  // á
+	{0x04, 0x0A, 0x0E, 0x01, 0x0F, 0x11, 0x0F, 0x00},  // â
+	{0x0D, 0x16, 0x0E, 0x01, 0x0F, 0x11, 0x0F, 0x00},  // ã
+	{0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E, 0x04, 0x0C},  // ç
+	{0x02, 0x04, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00},  // é
+	{0x04, 0x0A, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00},  // ê
+	{0x02, 0x04, 0x0C, 0x04, 0x04, 0x04, 0x0E, 0x00},  // í
+	{0x02, 0x04, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00},  // ó
+	{0x04, 0x0A, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00},  // ô
+	{0x0D, 0x16, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00},  // õ
+	{0x02, 0x04, 0x11, 0x11, 0x11, 0x13, 0x0D, 0x00},  // ú
+	{0x0A, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0D, 0x00},  // ü
+	{0x08, 0x04, 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11},  // À
+	{0x02, 0x04, 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11},  // Á
+	{0x04, 0x0A, 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11},  // Â
+	{0x0D, 0x16, 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11},  // Ã
+	{0x0E, 0x11, 0x10, 0x10, 0x11, 0x0E, 0x04, 0x0C},  // Ç
+	{0x02, 0x04, 0x1F, 0x10, 0x1E, 0x10, 0x10, 0x1F},  // É
+	{0x04, 0x0A, 0x1F, 0x10, 0x1E, 0x10, 0x10, 0x1F},  // Ê
+	{0x02, 0x04, 0x0E, 0x04, 0x04, 0x04, 0x04, 0x0E},  // Í
+	{0x02, 0x04, 0x0E, 0x11, 0x11, 0x11, 0x11, 0x0E},  // Ó
+	{0x04, 0x0A, 0x0E, 0x11, 0x11, 0x11, 0x11, 0x0E},  // Ô
+	{0x0D, 0x16, 0x0E, 0x11, 0x11, 0x11, 0x11, 0x0E},  // Õ
+	{0x02, 0x04, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E}   // Ú
+};
+
+static_assert(sizeof(glyphChars) == sizeof(glyphBitmaps) / 8, "Um desenho por letra");
+
+/*****************************************************************************/
+/* Construtor                                                                */
+/*****************************************************************************/
+GlyphCache::GlyphCache() : uploads(0), seen(0)
+{
+	memset(slots, 0, sizeof(slots));
+	memset(age, 0, sizeof(age));
+}
+
+/*****************************************************************************/
+/* map()                                                                     */
+/*****************************************************************************/
+byte GlyphCache::map(char c) const {
+	if ((byte) c < 0x80)
+		return c;
+	int8_t s = slotOf(c);
+	if (s >= 0)
+		return s;
+	return SerialProtocol::accentToAscii(c);
+}
+
+int8_t GlyphCache::slotOf(byte c) const {
+	for (byte s = 0; s < SLOTS; s++)
+		if (slots[s] == c)
+			return s;
+	return -1;
+}
+
+/*****************************************************************************/
+/* victim()                                                                  */
+/* Uma posição livre, se houver; senão, a que está há mais tempo sem         */
+/* aparecer. As idades param em 255, sem dar a volta. As já confirmadas      */
+/* nesta chamada de update() têm idade 0 e não são escolhidas, pois há no    */
+/* máximo SLOTS letras por chamada e uma delas ainda falta.                  */
+/*****************************************************************************/
+byte GlyphCache::victim() const {
+	byte oldest = 0;
+	for (byte s = 0; s < SLOTS; s++) {
+		if (slots[s] == 0)
+			return s;
+		if (age[s] > age[oldest])
+			oldest = s;
+	}
+	return oldest;
+}
+
+int8_t GlyphCache::glyphIndex(char c) {
+	if ((byte) c < 0xC0)
+		return -1;
+	for (byte g = 0; g < GLYPH_COUNT; g++)
+		if (pgm_read_byte(&glyphChars[g]) == (byte) c)
+			return g;
+	return -1;
+}
+
+byte GlyphCache::glyphChar(byte g) {
+	return pgm_read_byte(&glyphChars[g]);
+}
+
+void GlyphCache::glyphBitmap(byte g, byte *bitmap) {
+	memcpy_P(bitmap, glyphBitmaps[g], 8);
+}
+
+#endif // LCD_ACCENTS
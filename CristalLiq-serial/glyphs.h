@@ -0,0 +1,140 @@
+#ifndef GLYPHS_H
+#define GLYPHS_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "lcdbuffer.h"
+
+#ifdef LCD_ACCENTS
+
+/**
+ * @class GlyphCache
+ * @brief Mostra letras acentuadas desenhando-as nas 8 posições da CGRAM do HD44780.
+ *
+ * O texto das linhas fica em Windows-1252 (ou Latin-1) na tela em RAM. A
+ * cada alteração da tela, `update()` conta as letras acentuadas visíveis e
+ * garante que as 8 mais frequentes estejam na CGRAM. Uma letra que já está
+ * carregada nunca é regravada; quando falta posição, sai a que está há mais
+ * tempo sem aparecer (LRU). Cada carga custa `UPLOAD_COST` operações no LCD
+ * (36 bytes no I2C), por isso as posições só mudam quando uma letra
+ * escolhida não está carregada, e cada chamada de `update()` faz no máximo
+ * uma carga, descontada do orçamento da passada.
+ *
+ * Na escrita, `map()` troca cada letra carregada pela sua posição da CGRAM e
+ * as demais pelo equivalente sem acento (SerialProtocol::accentToAscii()).
+ *
+ * Há desenhos para à á â ã ç é ê í ó ô õ ú ü e as maiúsculas À Á Â Ã Ç É Ê
+ * Í Ó Ô Õ Ú, comprimidas para caber o acento nas 8 linhas.
+ */
+class GlyphCache {
+	public:
+		enum {
+			SLOTS = 8,        /**< Posições da CGRAM. */
+			UPLOAD_COST = 9   /**< Operações no LCD de uma carga: endereço da CGRAM e 8 linhas. */
+		};
+
+		/**
+		* @brief Caractere carregado em cada posição da CGRAM; 0 se livre.
+		*/
+		byte slots[SLOTS];
+
+		/**
+		* @brief Quantidade de desenhos gravados na CGRAM desde o início.
+		*/
+		unsigned int uploads;
+
+		GlyphCache();
+
+		/**
+		* @brief Ajusta a CGRAM às letras acentuadas visíveis em `fb.target`.
+		*
+		* Só trabalha se a tela mudou desde a última chamada que terminou as
+		* cargas. As letras escolhidas que já estão carregadas são marcadas
+		* como vistas antes de qualquer carga, para nenhuma delas ser a vítima.
+		* Falta carregar alguma? Grava a mais frequente e deixa as outras para
+		* as próximas chamadas; as posições que exibem a letra recarregada ou
+		* substituída são marcadas para reescrita, e a tela continua pendente
+		* (`fb.pending()`) até lá.
+		*
+		* @param lcd Controlador do _display_ (precisa de `createChar()` e `flush()`).
+		* @param fb  Tela em RAM.
+		* @return Operações feitas no LCD: 0 ou `UPLOAD_COST`.
+		*/
+		template <class LCD, byte COLS, byte ROWS>
+		byte update(LCD &lcd, LcdFrameBuffer<COLS, ROWS> &fb) {
+			if (fb.changes() == seen)
+				return 0;
+
+			byte count[GLYPH_COUNT];
+			memset(count, 0, sizeof(count));
+			for (byte row = 0; row < ROWS; row++)
+				for (byte col = 0; col < COLS; col++) {
+					int8_t g = glyphIndex(fb.target[row][col]);
+					if (g >= 0 && count[g] < 255)
+						count[g]++;
+				}
+
+			for (byte s = 0; s < SLOTS; s++)
+				if (age[s] < 255)
+					age[s]++;
+			int8_t missing = -1;
+			bool more = false;
+			for (byte pick = 0; pick < SLOTS; pick++) {
+				int8_t best = -1;
+				for (byte g = 0; g < GLYPH_COUNT; g++)
+					if (count[g] > 0 && (best < 0 || count[g] > count[best]))
+						best = g;
+				if (best < 0)
+					break;
+				count[best] = 0;
+				int8_t s = slotOf(glyphChar(best));
+				if (s >= 0)
+					age[s] = 0;
+				else if (missing < 0)
+					missing = best;
+				else
+					more = true;
+			}
+			if (!more)
+				seen = fb.changes();
+			if (missing < 0)
+				return 0;
+
+			byte c = glyphChar(missing);
+			byte s = victim();
+			if (slots[s] != 0)
+				fb.invalidate(slots[s]);
+			fb.invalidate(c);
+			byte bitmap[8];
+			glyphBitmap(missing, bitmap);
+			lcd.createChar(s, bitmap);
+			lcd.flush();
+			fb.loseCursor();
+			slots[s] = c;
+			age[s] = 0;
+			uploads++;
+			return UPLOAD_COST;
+		}
+
+		/**
+		* @brief Código a escrever no LCD para o caractere `c`.
+		*/
+		byte map(char c) const;
+
+		byte operator()(char c) const { return map(c); }
+
+	private:
+		enum { GLYPH_COUNT = 25 };
+		byte age[SLOTS];  // Chamadas de update() desde que a letra da posição esteve visível, até 255
+		byte seen;        // fb.changes() na última chamada de update() que terminou as cargas
+
+		int8_t slotOf(byte c) const;
+		byte victim() const;
+		static int8_t glyphIndex(char c);
+		static byte glyphChar(byte g);
+		static void glyphBitmap(byte g, byte *bitmap);
+};
+
+#endif // LCD_ACCENTS
+
+#endif // GLYPHS_H
@@ -0,0 +1,194 @@
+#include "hd44780.h"
+
+#if defined(LCD_PARALLEL)
+
+#include <avr/io.h>
+#include <util/atomic.h>
+
+#define LCD_RS  _BV(PB0)
+#define LCD_RW  _BV(PB1)
+#define LCD_E   _BV(PB2)
+#define LCD_E2  _BV(PB3)   // Segundo controlador das telas 40x4
+#define LCD_HI  0xF0    // D4..D7 em PORTD
+#define LCD_LO  0x0F    // D0..D3 em PORTC
+
+/*****************************************************************************/
+/* Funções comuns aos dois barramentos                                       */
+/* PORTD também tem o buzzer (PD2), alternado pela interrupção do tone():    */
+/* a leitura-modificação-escrita da porta precisa ser atômica.               */
+/*****************************************************************************/
+static void pulseEnable(byte enable) {
+	PORTB |= enable;
+	delayMicroseconds(1);  // Pulso mínimo de 450 ns
+	PORTB &= ~enable;
+}
+
+static void setHighNibble(byte value) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		PORTD = (PORTD & ~LCD_HI) | (value & LCD_HI);
+	}
+}
+
+static void setControl(bool rs) {
+	PORTB &= ~LCD_RW;
+	if (rs)
+		PORTB |= LCD_RS;
+	else
+		PORTB &= ~LCD_RS;
+}
+
+/*****************************************************************************/
+/* readBusy()                                                                */
+/* Solta as linhas de dados (D4..D7 e, no barramento de 8 bits, D0..D3 de    */
+/* lowMask) antes de o LCD passar a dirigi-las, lê o busy flag em D7 e       */
+/* completa o ciclo de leitura com os pulsos que faltam (um no barramento de */
+/* 8 bits, dois no de 4). Uma linha que ficasse como saída disputaria o      */
+/* barramento com o LCD.                                                     */
+/*****************************************************************************/
+static bool readBusy(byte enable, byte pulses, byte lowMask) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		DDRD &= ~LCD_HI;
+		PORTD &= ~LCD_HI;
+		DDRC &= ~lowMask;
+		PORTC &= ~lowMask;
+	}
+	PORTB &= ~LCD_RS;
+	PORTB |= LCD_RW;
+	PORTB |= enable;
+	delayMicroseconds(1);  // Dado válido 360 ns após a subida de E
+	bool busy = PIND & _BV(PD7);
+	PORTB &= ~enable;
+	while (--pulses)
+		pulseEnable(enable);
+	PORTB &= ~LCD_RW;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		DDRD |= LCD_HI;
+		DDRC |= lowMask;
+	}
+	return busy;
+}
+
+static void beginControl() {
+	DDRB |= LCD_RS | LCD_RW | LCD_E | LCD_E2;
+	PORTB &= ~(LCD_RS | LCD_RW | LCD_E | LCD_E2);
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		DDRD |= LCD_HI;
+	}
+	delay(50);  // Tensão estabilizando após ligar
+}
+
+/*****************************************************************************/
+/* Hd44780Bus4                                                               */
+/* Inicialização por instrução do datasheet: três vezes 8 bits (só o nibble  */
+/* alto existe na fiação) e então 4 bits. Antes disso o busy flag não vale.  */
+/*****************************************************************************/
+void Hd44780Bus4::begin() {
+	beginControl();
+	setControl(false);
+	setHighNibble(0x30);
+	pulseEnable(enable);
+	delayMicroseconds(4100);
+	pulseEnable(enable);
+	delayMicroseconds(100);
+	pulseEnable(enable);
+	delayMicroseconds(100);
+	setHighNibble(0x20);
+	pulseEnable(enable);
+	delayMicroseconds(100);
+}
+
+void Hd44780Bus4::write(byte value, bool rs) {
+	setControl(rs);
+	setHighNibble(value);
+	pulseEnable(enable);
+	setHighNibble(value << 4);
+	pulseEnable(enable);
+}
+
+bool Hd44780Bus4::busy() {
+	return readBusy(enable, 2, 0);
+}
+
+/*****************************************************************************/
+/* Hd44780Bus8                                                               */
+/*****************************************************************************/
+void Hd44780Bus8::begin() {
+	beginControl();
+	DDRC |= LCD_LO;
+	write(0x30, false);
+	delayMicroseconds(4100);
+	write(0x30, false);
+	delayMicroseconds(100);
+	write(0x30, false);
+	delayMicroseconds(100);
+}
+
+void Hd44780Bus8::write(byte value, bool rs) {
+	setControl(rs);
+	setHighNibble(value);
+	PORTC = (PORTC & ~LCD_LO) | (value & LCD_LO);
+	pulseEnable(enable);
+}
+
+bool Hd44780Bus8::busy() {
+	return readBusy(enable, 1, LCD_LO);
+}
+
+#elif !defined(LCD_LIQUIDCRYSTAL_I2C)
+
+#define PCF_RS  0x01
+#define PCF_E   0x04
+
+/*****************************************************************************/
+/* Hd44780BusI2c                                                             */
+/* A inicialização por instrução precisa de esperas entre os nibbles, então  */
+/* cada um sai na sua própria transação.                                     */
+/*****************************************************************************/
+void Hd44780BusI2c::begin() {
+	delay(50);  // Tensão estabilizando após ligar
+	count = 0;
+	batch[count++] = light;
+	flush();
+	writeNibble(0x30);
+	flush();
+	delayMicroseconds(4100);
+	writeNibble(0x30);
+	flush();
+	delayMicroseconds(100);
+	writeNibble(0x30);
+	flush();
+	delayMicroseconds(100);
+	writeNibble(0x20);
+	flush();
+}
+
+void Hd44780BusI2c::writeNibble(byte value) {
+	if (count > BUFFER_LENGTH - 2)
+		flush();
+	batch[count++] = value | light | PCF_E;
+	batch[count++] = value | light;   // O controlador lê na descida de E
+}
+
+/*****************************************************************************/
+/* write()                                                                   */
+/* clear (0x01) e home (0x02) são as únicas instruções lentas: o que está    */
+/* acumulado sai junto com ela e então espera-se a execução.                 */
+/*****************************************************************************/
+void Hd44780BusI2c::write(byte value, bool rs) {
+	byte control = rs ? PCF_RS : 0;
+	writeNibble((value & 0xF0) | control);
+	writeNibble((value << 4) | control);
+	if (!rs && value <= 0x03) {
+		flush();
+		delayMicroseconds(1600);
+	}
+}
+
+void Hd44780BusI2c::flush() {
+	if (count == 0)
+		return;
+	i2c.write(address, batch, count);
+	count = 0;
+}
+
+#endif
@@ -0,0 +1,284 @@
+#ifndef HD44780_H
+#define HD44780_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "i2cbus.h"
+
+/**
+ * @class Hd44780
+ * @brief Controlador HD44780, nos pinos do Arduino ou atrás de um PCF8574 no I2C.
+ *
+ * Tem a mesma interface usada do `LiquidCrystal_I2C` (`init()`, `clear()`,
+ * `setCursor()`, `write()`, `createChar()` ...), então o sketch troca de
+ * _backend_ só na declaração de `lcd` (opções `LCD_PARALLEL` e
+ * `LCD_LIQUIDCRYSTAL_I2C` em config.h).
+ *
+ * O protocolo do controlador fica aqui; o acesso aos pinos fica no
+ * barramento `BUS`, que precisa oferecer:
+ * - `begin()`: configura os pinos e faz a inicialização por instrução,
+ *   deixando o controlador na largura de dados do barramento;
+ * - `write(value, rs)`: escreve um byte de instrução (`rs` falso) ou de dado;
+ * - `busy()`: lê o _busy flag_;
+ * - `flush()`: transmite o que o barramento tiver acumulado;
+ * - `setBacklight(on)`: liga ou desliga a luz de fundo, se houver controle;
+ * - `select(n)`: escolhe o controlador (0 ou 1) que recebe as próximas operações;
+ * - a constante `DATA_LENGTH`: o bit DL do _function set_.
+ *
+ * Caracteres e posicionamentos do cursor podem ficar acumulados no
+ * barramento até `flush()`; as demais operações já saem transmitidas.
+ *
+ * Telas de 40x4 têm dois controladores, um para as linhas 0 e 1 e outro
+ * para as linhas 2 e 3, com pinos E separados; as demais são um só.
+ *
+ * Em vez dos atrasos fixos do `LiquidCrystal`, cada escrita espera o
+ * _busy flag_ baixar, o que leva uns 40 us por caractere. Trocando o
+ * barramento por um modelo do HD44780, a classe roda no PC
+ * (`Hd44780ModelBus`, em test/hd44780_model.h).
+ *
+ * @tparam BUS Barramento ligado ao controlador.
+ */
+template <class BUS>
+class Hd44780 : public Print {
+	public:
+		/**
+		* @brief Acesso aos pinos do controlador.
+		*/
+		BUS bus;
+
+		/**
+		* @param cols Colunas do _display_.
+		* @param rows Linhas do _display_.
+		* @param bus  Barramento, quando precisa de configuração (como o endereço I2C).
+		*/
+		Hd44780(byte cols, byte rows, const BUS &bus = BUS()) : bus(bus), cols(cols), rows(rows),
+		                                                      controllers(cols * rows > 80 ? 2 : 1),
+		                                                      control(DISPLAY_CONTROL | DISPLAY_ON) {}
+
+		/**
+		* @brief Inicializa os controladores: duas ou mais linhas, tela limpa, sem cursor.
+		*/
+		void init() {
+			for (byte c = 0; c < controllers; c++) {
+				bus.select(c);
+				bus.begin();
+				command(FUNCTION_SET | BUS::DATA_LENGTH | (rows > 1 ? TWO_LINES : 0));
+				command(control);
+				command(CLEAR_DISPLAY);
+				command(ENTRY_MODE | ENTRY_INCREMENT);
+			}
+			bus.select(0);
+			bus.flush();
+		}
+
+		/**
+		* @brief Limpa a tela e volta o cursor à origem.
+		*/
+		void clear() {
+			broadcast(CLEAR_DISPLAY);
+		}
+
+		/**
+		* @brief Posiciona o cursor.
+		*
+		* Com um só controlador, as linhas 2 e 3 continuam na memória as
+		* linhas 0 e 1.
+		*/
+		void setCursor(byte col, byte row) {
+			byte address = col + ((row & 1) ? 0x40 : 0);
+			if (controllers > 1)
+				bus.select(row >> 1);
+			else if (row & 2)
+				address += cols;
+			command(SET_DDRAM | address);
+		}
+
+		/**
+		* @brief Grava um caractere definido pelo usuário (0 a 7) na CGRAM.
+		*
+		* Como no `LiquidCrystal_I2C`, é preciso chamar `setCursor()` antes de
+		* voltar a escrever texto.
+		*
+		* @param location Posição na CGRAM.
+		* @param charmap  Oito linhas de 5 bits.
+		*/
+		void createChar(byte location, const byte charmap[]) {
+			for (byte c = 0; c < controllers; c++) {
+				bus.select(c);
+				command(SET_CGRAM | ((location & 7) << 3));
+				for (byte i = 0; i < 8; i++)
+					write(charmap[i]);
+			}
+		}
+
+		void noBlink() {
+			control &= ~BLINK_ON;
+			broadcast(control);
+		}
+
+		void noAutoscroll() {
+			broadcast(ENTRY_MODE | ENTRY_INCREMENT);
+		}
+
+		/**
+		* @brief Sem efeito: no HD44780 o contraste vem do trimpot em V0.
+		*/
+		void setContrast(byte) {}
+
+		/**
+		* @brief Liga (diferente de 0) ou desliga a luz de fundo.
+		*
+		* Só tem efeito no módulo I2C; na ligação direta a luz de fundo fica
+		* ligada na alimentação.
+		*/
+		void setBacklight(byte value) {
+			bus.setBacklight(value);
+			bus.flush();
+		}
+
+		/**
+		* @brief Envia uma instrução ao controlador.
+		*/
+		void command(byte value) {
+			waitReady();
+			bus.write(value, false);
+		}
+
+		/**
+		* @brief Escreve um caractere na posição do cursor.
+		*/
+		size_t write(uint8_t c) {
+			waitReady();
+			bus.write(c, true);
+			return 1;
+		}
+		using Print::write;
+
+		/**
+		* @brief Transmite os caracteres e posicionamentos acumulados no barramento.
+		*/
+		void flush() {
+			bus.flush();
+		}
+
+	private:
+		enum {
+			CLEAR_DISPLAY   = 0x01,
+			ENTRY_MODE      = 0x04,
+			ENTRY_INCREMENT = 0x02,
+			DISPLAY_CONTROL = 0x08,
+			DISPLAY_ON      = 0x04,
+			BLINK_ON        = 0x01,
+			FUNCTION_SET    = 0x20,
+			TWO_LINES       = 0x08,
+			SET_CGRAM       = 0x40,
+			SET_DDRAM       = 0x80,
+			BUSY_POLL_LIMIT = 1000  // Mais que o pior caso (clear, 1,52 ms); evita travar sem o LCD
+		};
+		byte cols;
+		byte rows;
+		byte controllers;
+		byte control;  // Último display control enviado
+
+		void broadcast(byte value) {
+			for (byte c = 0; c < controllers; c++) {
+				bus.select(c);
+				command(value);
+			}
+			bus.select(0);
+			bus.flush();
+		}
+
+		void waitReady() {
+			for (unsigned int i = 0; i < BUSY_POLL_LIMIT && bus.busy(); i++)
+				;
+		}
+};
+
+/**
+ * @brief Barramento de 4 bits: D4..D7 em PD4..PD7 (pinos 4 a 7).
+ *
+ * RS, RW e E ficam em PB0, PB1 e PB2 (pinos 8, 9 e 10); o E do segundo
+ * controlador das telas 40x4 fica em PB3 (pino 11). Cada byte custa dois
+ * pulsos em E.
+ */
+struct Hd44780Bus4 {
+	enum { DATA_LENGTH = 0x00 };
+	Hd44780Bus4() : enable(_BV(PB2)) {}
+	void begin();
+	void write(byte value, bool rs);
+	bool busy();
+	void flush() {}
+	void setBacklight(byte) {}
+	void select(byte controller) { enable = controller ? _BV(PB3) : _BV(PB2); }
+
+	private:
+		byte enable;  // Pino E do controlador escolhido, em PORTB
+};
+
+/**
+ * @brief Barramento de 8 bits: D0..D3 em PC0..PC3 (A0 a A3) e D4..D7 em PD4..PD7.
+ *
+ * PD0 e PD1 são da serial e PC4/PC5 do I2C do RTC, por isso o byte fica
+ * dividido entre as duas portas. RS, RW e E como em `Hd44780Bus4`. Cada
+ * byte custa um só pulso em E.
+ */
+struct Hd44780Bus8 {
+	enum { DATA_LENGTH = 0x10 };
+	Hd44780Bus8() : enable(_BV(PB2)) {}
+	void begin();
+	void write(byte value, bool rs);
+	bool busy();
+	void flush() {}
+	void setBacklight(byte) {}
+	void select(byte controller) { enable = controller ? _BV(PB3) : _BV(PB2); }
+
+	private:
+		byte enable;  // Pino E do controlador escolhido, em PORTB
+};
+
+/**
+ * @brief Barramento do módulo I2C (PCF8574), com as escritas agrupadas.
+ *
+ * Cada nibble vira dois bytes no expansor (com E alto e com E baixo), na
+ * ligação usual dos módulos: RS em P0, RW em P1, E em P2, luz de fundo em P3
+ * e D4..D7 em P4..P7. Em vez de uma transação por byte, como faz o
+ * `LiquidCrystal_I2C`, os bytes se acumulam em `batch` e saem pelo `i2c` em
+ * transações do tamanho do buffer da `Wire` (8 caracteres).
+ *
+ * O _busy flag_ não é lido: entre um caractere e o próximo passam pelo
+ * menos dois bytes no barramento (45 us a 400 kHz), mais que os 37 us de
+ * execução do controlador. Só `clear` e `home` esperam os 1,52 ms.
+ * Os módulos têm um só pino E, então não servem para telas 40x4.
+ */
+struct Hd44780BusI2c {
+	enum { DATA_LENGTH = 0x00 };
+
+	/**
+	* @param address Endereço de 7 bits do PCF8574.
+	*/
+	Hd44780BusI2c(byte address = 0x27) : address(address), light(BACKLIGHT), count(0) {}
+	void begin();
+	void write(byte value, bool rs);
+	bool busy() { return false; }
+	void flush();
+	void setBacklight(byte value) { light = value ? BACKLIGHT : 0; }
+	void select(byte) {}
+
+	private:
+		enum { BACKLIGHT = 0x08 };
+		byte address;
+		byte light;
+		byte count;                 // Bytes em batch
+		byte batch[BUFFER_LENGTH];
+		void writeNibble(byte value);
+};
+
+#ifdef LCD_PARALLEL_8BIT
+typedef Hd44780<Hd44780Bus8> Hd44780Parallel;
+#else
+typedef Hd44780<Hd44780Bus4> Hd44780Parallel;
+#endif
+typedef Hd44780<Hd44780BusI2c> Hd44780I2c;
+
+#endif // HD44780_H
@@ -0,0 +1,63 @@
+#include "health.h"
+
+Health health;
+
+extern char __heap_start;  // Fim das variáveis globais, definido pelo ligador
+extern char *__brkval;     // Fim do heap; NULL enquanto malloc() não foi usado
+
+/*****************************************************************************/
+/* Fim da região usada pelo heap, ou pelas variáveis globais.                */
+/*****************************************************************************/
+static char *heapEnd() {
+	return __brkval == NULL ? &__heap_start : __brkval;
+}
+
+/*****************************************************************************/
+/* Construtor                                                                */
+/*****************************************************************************/
+Health::Health() : loopsPerSecond(0), lastPasses(0), lastSample(0)
+{
+}
+
+/*****************************************************************************/
+/* begin()                                                                   */
+/* O SP aponta para o próximo byte livre da pilha; dali para baixo nada está */
+/* em uso. Uma interrupção que empilhe durante a pintura já terá saído       */
+/* quando o laço passar por cima.                                            */
+/*****************************************************************************/
+void Health::begin() {
+	char *top = (char *) SP;
+	for (char *p = heapEnd(); p < top; p++)
+		*p = STACK_CANARY;
+}
+
+/*****************************************************************************/
+/* updateRate()                                                              */
+/* Janela de um segundo, como em I2cBus::updateRates().                      */
+/*****************************************************************************/
+void Health::updateRate(unsigned long passes) {
+	unsigned long elapsed = millis() - lastSample;
+	if (elapsed < 1000)
+		return;
+	loopsPerSecond = (passes - lastPasses) * 1000UL / elapsed;
+	lastPasses = passes;
+	lastSample += elapsed;
+}
+
+/*****************************************************************************/
+/* freeRam()                                                                 */
+/*****************************************************************************/
+unsigned int Health::freeRam() {
+	return (char *) SP - heapEnd();
+}
+
+/*****************************************************************************/
+/* stackHeadroom()                                                           */
+/*****************************************************************************/
+unsigned int Health::stackHeadroom() {
+	char *top = (char *) SP;
+	char *p = heapEnd();
+	while (p < top && *p == (char) STACK_CANARY)
+		p++;
+	return p - heapEnd();
+}
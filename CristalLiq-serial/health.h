@@ -0,0 +1,64 @@
+#ifndef HEALTH_H
+#define HEALTH_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define STACK_CANARY  0xC5  /**< Valor pintado na SRAM livre por `Health::begin()`. */
+
+/**
+ * @class Health
+ * @brief Indicadores de saúde da placa: ritmo do `loop()`, pilha e SRAM livre.
+ *
+ * A SRAM livre fica entre o fim do _heap_ (ou das variáveis globais, sem
+ * `malloc()`) e o topo da pilha, que cresce para baixo. `begin()` pinta essa
+ * região com `STACK_CANARY`; o quanto dela continua pintado é a menor folga
+ * que a pilha já deixou, inclusive nas interrupções.
+ */
+class Health {
+	public:
+		/**
+		* @brief Passadas do `loop()` por segundo na última janela de `updateRate()`.
+		*/
+		unsigned int loopsPerSecond;
+
+		Health();
+
+		/**
+		* @brief Pinta a SRAM livre abaixo da pilha atual.
+		*
+		* Deve ser chamada no começo do `setup()`, com a pilha ainda rasa.
+		*/
+		void begin();
+
+		/**
+		* @brief Recalcula `loopsPerSecond`, no máximo uma vez por segundo.
+		*
+		* @param passes Total de passadas do `loop()` (`Scheduler::passes`).
+		*/
+		void updateRate(unsigned long passes);
+
+		/**
+		* @brief Bytes entre o fim do _heap_ e o topo atual da pilha.
+		*/
+		static unsigned int freeRam();
+
+		/**
+		* @brief Menor distância que a pilha já chegou do fim do _heap_, em bytes.
+		*
+		* Percorre a região pintada a partir do fim do _heap_ até o primeiro
+		* byte alterado: algumas centenas de microssegundos.
+		*/
+		static unsigned int stackHeadroom();
+
+	private:
+		unsigned long lastPasses;
+		unsigned long lastSample;
+};
+
+/**
+ * @brief Instância única, usada pelo sketch.
+ */
+extern Health health;
+
+#endif // HEALTH_H
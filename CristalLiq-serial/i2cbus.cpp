@@ -0,0 +1,69 @@
+#include "i2cbus.h"
+
+I2cBus i2c;
+
+/*****************************************************************************/
+/* Construtor                                                                */
+/*****************************************************************************/
+I2cBus::I2cBus() : transactions(0), bytes(0), errors(0), transactionsPerSecond(0), bytesPerSecond(0),
+                   lastTransactions(0), lastBytes(0), lastSample(0)
+{
+}
+
+void I2cBus::begin() {
+	Wire.setClock(I2C_CLOCK);
+}
+
+/*****************************************************************************/
+/* write()                                                                   */
+/*****************************************************************************/
+bool I2cBus::write(byte address, const byte *data, byte size) {
+	bool ok = true;
+	while (size > 0) {
+		byte chunk = size < BUFFER_LENGTH ? size : BUFFER_LENGTH;
+		Wire.beginTransmission(address);
+		Wire.write(data, chunk);
+		if (Wire.endTransmission() != 0) {
+			errors++;
+			ok = false;
+		}
+		transactions++;
+		bytes += chunk;
+		data += chunk;
+		size -= chunk;
+	}
+	return ok;
+}
+
+/*****************************************************************************/
+/* read()                                                                    */
+/*****************************************************************************/
+bool I2cBus::read(byte address, byte reg, byte *data, byte size) {
+	Wire.beginTransmission(address);
+	Wire.write(reg);
+	transactions += 2;
+	bytes++;
+	if (Wire.endTransmission(false) != 0 || Wire.requestFrom(address, size) != size) {
+		errors++;
+		return false;
+	}
+	for (byte i = 0; i < size; i++)
+		data[i] = Wire.read();
+	bytes += size;
+	return true;
+}
+
+/*****************************************************************************/
+/* updateRates()                                                             */
+/* Janela de um segundo; o resultado é exato mesmo se a chamada atrasar.     */
+/*****************************************************************************/
+void I2cBus::updateRates() {
+	unsigned long elapsed = millis() - lastSample;
+	if (elapsed < 1000)
+		return;
+	transactionsPerSecond = (transactions - lastTransactions) * 1000UL / elapsed;
+	bytesPerSecond = (bytes - lastBytes) * 1000UL / elapsed;
+	lastTransactions = transactions;
+	lastBytes = bytes;
+	lastSample += elapsed;
+}
@@ -0,0 +1,103 @@
+#ifndef I2CBUS_H
+#define I2CBUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include "config.h"
+
+/**
+ * @def I2C_CLOCK
+ * @brief Frequência do barramento: a maior aceita por todos os dispositivos ligados nele.
+ */
+#ifdef LCD_PARALLEL
+#define I2C_CLOCK  I2C_RTC_MAX_CLOCK
+#else
+#define I2C_CLOCK  min(I2C_LCD_MAX_CLOCK, I2C_RTC_MAX_CLOCK)
+#endif
+
+/**
+ * @class I2cBus
+ * @brief Ponto único de acesso ao barramento I2C compartilhado pelo LCD e pelo DS3231.
+ *
+ * Configura o relógio do barramento e transfere blocos de bytes em
+ * transações do tamanho do buffer da `Wire`, contando transações e bytes.
+ *
+ * O barramento só é usado no `loop()`, nunca em interrupções. Cada lote do
+ * LCD é transmitido por inteiro antes de o `loop()` seguir, então as leituras
+ * do RTC sempre caem entre dois lotes, sem disputa.
+ */
+class I2cBus {
+	public:
+		/**
+		* @brief Transações concluídas desde o início.
+		*/
+		unsigned long transactions;
+
+		/**
+		* @brief Bytes de dados transmitidos desde o início (sem o endereço).
+		*/
+		unsigned long bytes;
+
+		/**
+		* @brief Transações sem ACK ou com erro no barramento.
+		*/
+		unsigned int errors;
+
+		/**
+		* @brief Transações por segundo na última janela de `updateRates()`.
+		*/
+		unsigned int transactionsPerSecond;
+
+		/**
+		* @brief Bytes por segundo na última janela de `updateRates()`.
+		*/
+		unsigned int bytesPerSecond;
+
+		I2cBus();
+
+		/**
+		* @brief Ajusta o relógio do barramento para `I2C_CLOCK`.
+		*
+		* Deve ser chamada depois das bibliotecas que executam `Wire.begin()`
+		* (RTClib, LiquidCrystal_I2C), pois ele volta o relógio para 100 kHz.
+		*/
+		void begin();
+
+		/**
+		* @brief Escreve um bloco num dispositivo, em tantas transações quanto o buffer da `Wire` exigir.
+		*
+		* @param address Endereço de 7 bits.
+		* @param data    Bytes a escrever.
+		* @param size    Quantidade de bytes.
+		* @return `false` se alguma transação falhou.
+		*/
+		bool write(byte address, const byte *data, byte size);
+
+		/**
+		* @brief Lê registradores consecutivos de um dispositivo.
+		*
+		* Escreve o endereço do primeiro registrador e lê em seguida, com
+		* _repeated start_; conta como duas transações.
+		*
+		* @param address Endereço de 7 bits.
+		* @param reg     Primeiro registrador.
+		* @param data    Destino dos bytes lidos.
+		* @param size    Quantidade de bytes, no máximo `BUFFER_LENGTH`.
+		* @return `false` se o dispositivo não respondeu ou entregou menos bytes.
+		*/
+		bool read(byte address, byte reg, byte *data, byte size);
+
+		/**
+		* @brief Recalcula as taxas por segundo; pode ser chamada a qualquer momento, a janela só fecha depois de 1 s.
+		*/
+		void updateRates();
+
+	private:
+		unsigned long lastTransactions;
+		unsigned long lastBytes;
+		unsigned long lastSample;
+};
+
+extern I2cBus i2c;
+
+#endif // I2CBUS_H
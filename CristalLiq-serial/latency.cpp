@@ -0,0 +1,140 @@
+#include "latency.h"
+
+#ifdef LATENCY_STATS
+
+LatencyStats latency;
+
+/*****************************************************************************/
+/* Construtor                                                                */
+/*****************************************************************************/
+LatencyStats::LatencyStats() : frameEnd(0), parseEnd(0), replyAt(0), replied(false), sending(NULL)
+{
+	reset();
+}
+
+/*****************************************************************************/
+/* begin()                                                                   */
+/* Modo normal, sem comparação nem interrupção; prescaler 64.                */
+/*****************************************************************************/
+void LatencyStats::begin() {
+	TCCR1A = 0;
+	TCCR1B = _BV(CS11) | _BV(CS10);
+}
+
+/*****************************************************************************/
+/* reset()                                                                   */
+/*****************************************************************************/
+void LatencyStats::reset() {
+	memset(entries, 0, sizeof(entries));
+	untracked = 0;
+	sending = NULL;
+}
+
+/*****************************************************************************/
+/* find()                                                                    */
+/* Uma posição livre passa a ser do código na primeira vez que ele aparece.  */
+/*****************************************************************************/
+LatencyStats::Entry *LatencyStats::find(int code) {
+	for (byte i = 0; i < LATENCY_SLOTS; i++) {
+		if (entries[i].code == code)
+			return &entries[i];
+		if (entries[i].code == 0) {
+			entries[i].code = code;
+			return &entries[i];
+		}
+	}
+	return NULL;
+}
+
+/*****************************************************************************/
+/* handled()                                                                 */
+/* As faixas do histograma crescem de 4 em 4 vezes a partir de 128 µs. Com a */
+/* contagem saturada, só o mínimo e o máximo continuam valendo.              */
+/*****************************************************************************/
+void LatencyStats::handled(int code) {
+	uint16_t end = LATENCY_STAMP();
+	if (code == 0)
+		return;
+	if (!replied)
+		replyAt = end;
+	Entry *e = find(code);
+	if (e == NULL) {
+		untracked++;
+		return;
+	}
+	sending = replied ? e : NULL;
+	uint16_t total = replyAt - frameEnd;
+	if (e->count == 0 || total < e->min)
+		e->min = total;
+	if (total > e->max)
+		e->max = total;
+	if (e->count == 0xFFFF)
+		return;
+	e->count++;
+	e->sumReply += total;
+	e->sumParse += (uint16_t) (parseEnd - frameEnd);
+	e->sumHandler += (uint16_t) (end - parseEnd);
+	byte bucket = 0;
+	for (uint16_t limit = 128 / LATENCY_TICK_US; bucket < LATENCY_BUCKETS - 1 && total >= limit; limit <<= 2)
+		bucket++;
+	e->histogram[bucket]++;
+}
+
+/*****************************************************************************/
+/* drained()                                                                 */
+/* Conta do primeiro byte da resposta, que já está em `replyAt`.             */
+/*****************************************************************************/
+void LatencyStats::drained() {
+	uint16_t end = LATENCY_STAMP();
+	if (sending == NULL)
+		return;
+	if (sending->sent != 0xFFFF) {
+		sending->sent++;
+		sending->sumSend += (uint16_t) (end - replyAt);
+	}
+	sending = NULL;
+}
+
+/*****************************************************************************/
+/* Acrescenta ":valor" e devolve o novo fim da string.                       */
+/*****************************************************************************/
+static char *appendField(char *p, unsigned long value) {
+	*p++ = ':';
+	ultoa(value, p, 10);
+	return p + strlen(p);
+}
+
+/*****************************************************************************/
+/* format()                                                                  */
+/*****************************************************************************/
+bool LatencyStats::format(byte page, char *out) {
+	byte slot = page / 3;
+	out[0] = '\0';
+	if (slot >= LATENCY_SLOTS || entries[slot].code == 0)
+		return false;
+	const Entry &e = entries[slot];
+	unsigned long count = e.count == 0 ? 1 : e.count;
+	char *p = out;
+	itoa(e.code, p, 10);
+	p += strlen(p);
+	switch (page % 3) {
+		case 0:
+			p = appendField(p, e.count);
+			p = appendField(p, (unsigned long) e.min * LATENCY_TICK_US);
+			p = appendField(p, e.sumReply / count * LATENCY_TICK_US);
+			p = appendField(p, (unsigned long) e.max * LATENCY_TICK_US);
+			break;
+		case 1:
+			p = appendField(p, e.sumParse / count * LATENCY_TICK_US);
+			p = appendField(p, e.sumHandler / count * LATENCY_TICK_US);
+			p = appendField(p, e.sumSend / (e.sent == 0 ? 1 : e.sent) * LATENCY_TICK_US);
+			break;
+		case 2:
+			for (byte b = 0; b < LATENCY_BUCKETS; b++)
+				p = appendField(p, e.histogram[b]);
+			break;
+	}
+	return true;
+}
+
+#endif // LATENCY_STATS
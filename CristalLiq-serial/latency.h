@@ -0,0 +1,157 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#ifdef LATENCY_STATS
+
+#define LATENCY_TICK_US  4  /**< Microssegundos por contagem do Timer1 (16 MHz / 64). */
+#define LATENCY_BUCKETS  6  /**< Faixas do histograma: até 128 µs, 512 µs, 2 ms, 8 ms, 32 ms e acima. */
+
+/**
+ * @brief Instante atual em contagens do Timer1.
+ *
+ * Uma leitura de registrador de 16 bits, bem mais barata que `micros()`.
+ * Volta a zero a cada 262 ms; os intervalos medidos são bem menores.
+ */
+#define LATENCY_STAMP() ((uint16_t) TCNT1)
+
+/**
+ * @class LatencyStats
+ * @brief Tempos de resposta de cada código de comando.
+ *
+ * Cada quadro é marcado em cinco pontos: fim do quadro (o '>' final,
+ * guardado junto com o quadro na fila), fim do `parseMessage()`, primeiro
+ * byte da resposta (`SerialProtocol::sendFrame()`/`sendBinary()`), fim do
+ * tratamento e fila de transmissão vazia. Por código são acumulados
+ * quantidade, mínimo, máximo e soma do tempo até a resposta, as somas do
+ * tempo de decodificação, de tratamento e de transmissão, e um histograma do
+ * tempo até a resposta em faixas de 4x.
+ *
+ * Sem `RX_ISR_DECODE` o fim do quadro é o instante em que `receiveFrame()`
+ * o decodificou; a espera até a tarefa da serial rodar fica de fora.
+ *
+ * Os valores ficam em contagens do Timer1 (`LATENCY_TICK_US`), que só é
+ * usado para isso nesta opção.
+ */
+class LatencyStats {
+	public:
+		/**
+		* @brief Acumulados de um código de comando.
+		*/
+		struct Entry {
+			int code;                             /**< Código; 0 se a posição está livre. */
+			uint16_t count;                       /**< Quadros medidos (satura em 65535). */
+			uint16_t min;                         /**< Menor tempo até a resposta. */
+			uint16_t max;                         /**< Maior tempo até a resposta. */
+			uint32_t sumReply;                    /**< Soma dos tempos até a resposta. */
+			uint32_t sumParse;                    /**< Soma dos tempos do fim do quadro ao fim da decodificação. */
+			uint32_t sumHandler;                  /**< Soma dos tempos de tratamento, depois da decodificação. */
+			uint16_t sent;                        /**< Respostas com o fim da transmissão medido (satura em 65535). */
+			uint32_t sumSend;                     /**< Soma dos tempos do primeiro byte da resposta à fila vazia. */
+			uint16_t histogram[LATENCY_BUCKETS];  /**< Quadros por faixa de tempo até a resposta. */
+		};
+
+		/**
+		* @brief Um acumulado por código, na ordem em que os códigos apareceram.
+		*/
+		Entry entries[LATENCY_SLOTS];
+
+		/**
+		* @brief Quadros de códigos que não couberam em `entries`.
+		*/
+		uint16_t untracked;
+
+		LatencyStats();
+
+		/**
+		* @brief Liga o Timer1 contando livre a 250 kHz.
+		*/
+		void begin();
+
+		/**
+		* @brief Zera os acumulados.
+		*/
+		void reset();
+
+		/**
+		* @brief Começa a medir um quadro.
+		*
+		* @param frameEnd Instante do '>' final (`LATENCY_STAMP()`).
+		*/
+		void start(uint16_t frameEnd) {
+			this->frameEnd = frameEnd;
+			replied = false;
+		}
+
+		/**
+		* @brief Marca o fim da decodificação.
+		*/
+		void parsed() { parseEnd = LATENCY_STAMP(); }
+
+		/**
+		* @brief Marca o primeiro byte da resposta; as respostas seguintes do mesmo quadro são ignoradas.
+		*/
+		void reply() {
+			if (!replied) {
+				replyAt = LATENCY_STAMP();
+				replied = true;
+			}
+		}
+
+		/**
+		* @brief Marca o fim do tratamento e acumula os tempos no código.
+		*
+		* Se o quadro não teve resposta, o fim do tratamento conta como resposta.
+		*
+		* @param code Código do comando; 0 (quadro inválido) não é acumulado.
+		*/
+		void handled(int code);
+
+		/**
+		* @brief Indica que a resposta do último quadro tratado ainda está na fila de transmissão.
+		*/
+		bool draining() const { return sending != NULL; }
+
+		/**
+		* @brief Marca a fila de transmissão vazia e acumula o tempo de transmissão.
+		*
+		* Chamado pelo `loop()` quando `SerialProtocol::pendingOutput()` chega
+		* a 0; o último byte ainda está saindo pelo registrador de
+		* deslocamento. Se outro quadro foi tratado antes disso, só o último
+		* é medido.
+		*/
+		void drained();
+
+		/**
+		* @brief Escreve uma página dos acumulados, em microssegundos.
+		*
+		* Cada código ocupa três páginas:
+		* - `3k`: `CODIGO:QUANTIDADE:MIN:MEDIA:MAX` do tempo até a resposta;
+		* - `3k+1`: `CODIGO:DECODIFICACAO:TRATAMENTO:TRANSMISSAO`, as médias de cada etapa;
+		* - `3k+2`: `CODIGO:H0:...:H5`, o histograma.
+		*
+		* @param page Página.
+		* @param out  Destino, com pelo menos 40 bytes.
+		* @return `false` se a página não existe ou o código está vazio (`out` fica vazio).
+		*/
+		bool format(byte page, char *out);
+
+	private:
+		uint16_t frameEnd;
+		uint16_t parseEnd;
+		uint16_t replyAt;
+		bool replied;
+		Entry *sending;       // Código do último quadro, até a fila esvaziar; NULL se nenhum
+		Entry *find(int code);
+};
+
+/**
+ * @brief Instância única, usada por SerialProtocol e pelo sketch.
+ */
+extern LatencyStats latency;
+
+#endif // LATENCY_STATS
+
+#endif // LATENCY_H
@@ -0,0 +1,211 @@
+#ifndef LCDBUFFER_H
+#define LCDBUFFER_H
+
+#include <Arduino.h>
+
+/**
+ * @class LcdFrameBuffer
+ * @brief Cópia em RAM do _display_ HD44780, enviada aos poucos ao LCD.
+ *
+ * Cada caractere enviado ao LCD por um módulo I2C (PCF8574) custa várias
+ * transações no barramento. A classe guarda duas telas:
+ * - `target`: o que deve aparecer, escrito por `setLine()`;
+ * - `shadow`: o que já está no LCD.
+ *
+ * `flush()` envia as diferenças em fatias de tamanho limitado e retoma de
+ * onde parou na chamada seguinte; assim o `loop()` volta a atender a serial
+ * mesmo quando a tela inteira mudou. Linhas paradas não custam nada.
+ *
+ * O posicionamento do cursor custa o mesmo que um caractere, e o HD44780
+ * avança o cursor sozinho a cada escrita, então só há `setCursor()` no
+ * início de cada trecho alterado.
+ *
+ * @tparam COLS Colunas do _display_.
+ * @tparam ROWS Linhas do _display_ (no máximo 8).
+ */
+template <byte COLS, byte ROWS>
+class LcdFrameBuffer {
+	static_assert(ROWS >= 1 && ROWS <= 8, "As linhas pendentes sao marcadas num byte");
+
+	public:
+		/**
+		* @brief Caracteres que estão no LCD, linha a linha.
+		*/
+		char shadow[ROWS][COLS];
+
+		/**
+		* @brief Caracteres que devem estar no LCD, linha a linha.
+		*/
+		char target[ROWS][COLS];
+
+		LcdFrameBuffer() { reset(); }
+
+		/**
+		* @brief Marca a tela como em branco; deve acompanhar cada `lcd.clear()`.
+		*/
+		void reset() {
+			memset(shadow, ' ', sizeof(shadow));
+			memset(target, ' ', sizeof(target));
+			memset(stale, 0, sizeof(stale));
+			dirty = 0;
+			revision = 0;
+			nextRow = 0;
+			priorityRow = NO_ROW;
+			cursorRow = 0;             // clear() deixa o cursor na origem
+			cursorCol = 0;
+		}
+
+		/**
+		* @brief Define o conteúdo de uma linha; o LCD só muda em `flush()`.
+		*
+		* @param row  Linha, de 0 a ROWS-1.
+		* @param text Exatamente COLS caracteres.
+		*/
+		void setLine(byte row, const char *text) {
+			memcpy(target[row], text, COLS);
+			touch(row);
+		}
+
+		/**
+		* @brief Linha de `target`, para ser montada no lugar; depois chame `touch()`.
+		*/
+		char *edit(byte row) {
+			return target[row];
+		}
+
+		/**
+		* @brief Registra a alteração de uma linha feita por `edit()`.
+		*/
+		void touch(byte row) {
+			if (memcmp(target[row], shadow[row], COLS) != 0) {
+				dirty |= _BV(row);
+				revision++;
+			}
+			else if (!hasStale(row))
+				dirty &= ~_BV(row);
+		}
+
+		/**
+		* @brief Muda a cada alteração de `target`; permite saber se algo mudou desde a última consulta.
+		*/
+		byte changes() const {
+			return revision;
+		}
+
+		/**
+		* @brief Força a reescrita das posições que exibem o caractere `c`.
+		*
+		* Usada quando o desenho de um caractere muda no LCD (CGRAM). As
+		* posições ficam marcadas à parte de `shadow`, que continua com o
+		* caractere: qualquer valor, inclusive `'\0'`, pode estar no texto.
+		*/
+		void invalidate(char c) {
+			for (byte row = 0; row < ROWS; row++)
+				for (byte col = 0; col < COLS; col++)
+					if (shadow[row][col] == c) {
+						stale[row][col >> 3] |= _BV(col & 7);
+						dirty |= _BV(row);
+					}
+		}
+
+		/**
+		* @brief Avisa que o cursor do LCD saiu do lugar (por exemplo, após `createChar()`).
+		*/
+		void loseCursor() {
+			cursorRow = NO_ROW;
+		}
+
+		/**
+		* @brief Faz a linha passar à frente das demais nos próximos `flush()`, até ela ser enviada por inteiro.
+		*/
+		void promote(byte row) {
+			priorityRow = row;
+		}
+
+		/**
+		* @brief Indica se ainda há diferença entre `target` e o LCD.
+		*/
+		bool pending() const {
+			return dirty != 0;
+		}
+
+		/**
+		* @brief Envia ao LCD parte das diferenças pendentes.
+		*
+		* Começa pela linha promovida, se houver, e depois segue as demais em
+		* rodízio, retomando a linha interrompida na chamada anterior.
+		*
+		* @param lcd    Controlador do _display_ (precisa de `setCursor()`, `write()`
+		*               e `flush()`, chamado ao fim para transmitir o lote).
+		* @param budget Máximo de operações no LCD (caracteres e posicionamentos
+		*               do cursor); pode ser excedido em uma.
+		* @return Operações realizadas.
+		*/
+		template <class LCD>
+		byte flush(LCD &lcd, byte budget) {
+			return flush(lcd, budget, identity);
+		}
+
+		/**
+		* @brief Como `flush(lcd, budget)`, convertendo cada caractere pelo código do LCD.
+		*
+		* @param map Função ou objeto que recebe o caractere de `target` e devolve o código a escrever.
+		*/
+		template <class LCD, class MAP>
+		byte flush(LCD &lcd, byte budget, const MAP &map) {
+			byte used = 0;
+			while (dirty && used < budget) {
+				byte row = (priorityRow != NO_ROW && (dirty & _BV(priorityRow))) ? priorityRow : nextRow;
+				if (!(dirty & _BV(row))) {
+					nextRow = (nextRow + 1) % ROWS;
+					continue;
+				}
+				byte col = 0;
+				for (; col < COLS && used < budget; col++) {
+					char c = target[row][col];
+					byte bit = _BV(col & 7);
+					if (shadow[row][col] == c && !(stale[row][col >> 3] & bit))
+						continue;
+					if (cursorRow != row || cursorCol != col) {
+						lcd.setCursor(col, row);
+						used++;
+					}
+					lcd.write((uint8_t) map(c));
+					used++;
+					shadow[row][col] = c;
+					stale[row][col >> 3] &= ~bit;
+					cursorRow = row;
+					cursorCol = col + 1;   // Em COLS não corresponde a nenhuma coluna: força setCursor()
+				}
+				if (col == COLS) {
+					dirty &= ~_BV(row);
+					if (row == priorityRow)
+						priorityRow = NO_ROW;
+				}
+			}
+			if (used)
+				lcd.flush();
+			return used;
+		}
+
+	private:
+		enum { NO_ROW = 0xFF };
+		byte dirty;        // Bit por linha com diferença entre target e shadow
+		byte revision;     // Contador de alterações em target
+		byte nextRow;      // Linha em atendimento no rodízio
+		byte priorityRow;  // Linha promovida, ou NO_ROW
+		byte cursorRow;    // Posição atual do cursor do LCD
+		byte cursorCol;
+		byte stale[ROWS][(COLS + 7) / 8];  // Bit por posição a reescrever mesmo igual a shadow (invalidate())
+
+		bool hasStale(byte row) const {
+			for (byte i = 0; i < sizeof(stale[0]); i++)
+				if (stale[row][i])
+					return true;
+			return false;
+		}
+
+		static char identity(char c) { return c; }
+};
+
+#endif // LCDBUFFER_H
@@ -0,0 +1,123 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <Arduino.h>
+
+/**
+ * @brief Barreira de compilador: impede que escritas no buffer sejam
+ *        reordenadas depois da atualização dos índices.
+ */
+#define RING_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+/**
+ * @class RingBuffer
+ * @brief Fila circular sem travas para um produtor e um consumidor (SPSC).
+ *
+ * Feita para ligar uma rotina de interrupção (produtor) ao `loop()`
+ * (consumidor): cada lado só escreve no seu próprio índice, e índices de um
+ * byte são lidos e escritos atomicamente no AVR, então não é preciso
+ * desligar interrupções.
+ *
+ * Como no `HardwareSerial` do núcleo Arduino, uma posição fica sempre vaga
+ * para distinguir fila cheia de fila vazia: cabem `SIZE - 1` elementos. A
+ * posição vaga é a que `slot()` devolve, o que permite ao produtor montar um
+ * elemento no lugar antes de publicá-lo com `commit()`.
+ *
+ * @tparam T     Tipo do elemento.
+ * @tparam SIZE  Número de posições; potência de 2, no máximo 256.
+ */
+template <typename T, unsigned int SIZE>
+class RingBuffer {
+	static_assert(SIZE >= 2 && SIZE <= 256 && (SIZE & (SIZE - 1)) == 0,
+	              "SIZE deve ser potencia de 2 entre 2 e 256");
+	public:
+		/**
+		* @brief Maior ocupação já observada desde o último `resetHighWater()`.
+		*/
+		volatile byte highWater;
+
+		RingBuffer() : highWater(0), head(0), tail(0) {}
+
+		/** @brief Quantidade de elementos na fila. */
+		byte count() const { return (byte) (head - tail) & MASK; }
+		/** @brief Indica se não há elementos a consumir. */
+		bool empty() const { return head == tail; }
+		/** @brief Indica se não cabe mais nenhum elemento. */
+		bool full() const { return (byte) ((head + 1) & MASK) == tail; }
+
+		/**
+		* @brief Lado produtor: posição livre onde o próximo elemento pode ser montado.
+		*/
+		T *slot() { return &buf[head]; }
+
+		/**
+		* @brief Lado produtor: publica o elemento montado em `slot()`.
+		* @return `false` se a fila está cheia; o elemento é descartado.
+		*/
+		bool commit() {
+			byte next = (head + 1) & MASK;
+			if (next == tail)
+				return false;
+			RING_BARRIER();
+			head = next;
+			byte c = count();
+			if (c > highWater)
+				highWater = c;
+			return true;
+		}
+
+		/**
+		* @brief Lado produtor: copia `v` para a fila.
+		* @return `false` se a fila está cheia.
+		*/
+		bool push(const T &v) {
+			if (full())
+				return false;
+			buf[head] = v;
+			return commit();
+		}
+
+		/**
+		* @brief Lado consumidor: elemento mais antigo, sem retirá-lo, ou NULL se vazia.
+		*/
+		T *front() { return empty() ? NULL : &buf[tail]; }
+
+		/**
+		* @brief Lado consumidor: libera o elemento devolvido por `front()`.
+		*/
+		void drop() {
+			RING_BARRIER();
+			tail = (tail + 1) & MASK;
+		}
+
+		/**
+		* @brief Lado consumidor: retira o elemento mais antigo.
+		* @return `false` se a fila está vazia.
+		*/
+		bool pop(T &v) {
+			if (empty())
+				return false;
+			v = buf[tail];
+			drop();
+			return true;
+		}
+
+		/**
+		* @brief Lado consumidor: descarta todos os elementos já publicados.
+		*/
+		void clear() {
+			RING_BARRIER();
+			tail = head;
+		}
+
+		/** @brief Zera a marca de ocupação máxima. */
+		void resetHighWater() { highWater = count(); }
+
+	private:
+		static const byte MASK = SIZE - 1;
+		T buf[SIZE];
+		volatile byte head;
+		volatile byte tail;
+};
+
+#endif // RINGBUFFER_H
@@ -0,0 +1,186 @@
+#include <util/atomic.h>
+#include "rtcclock.h"
+#include "i2cbus.h"
+
+RtcClock rtcClock;
+
+static void sqwIsr()
+{
+	rtcClock.tickIsr();
+}
+
+/*****************************************************************************/
+/* Construtor                                                                */
+/*****************************************************************************/
+RtcClock::RtcClock() : temperature(0), rtc(NULL), seconds(SECONDS_FROM_1970_TO_2000), tickMillis(0), ticked(false), synced(false)
+{
+}
+
+/*****************************************************************************/
+/* begin()                                                                   */
+/*****************************************************************************/
+void RtcClock::begin(RTC_DS3231 &rtc) {
+	this->rtc = &rtc;
+	rtc.writeSqwPinMode(DS3231_SquareWave1Hz);
+	pinMode(RTC_SQW_PIN, INPUT_PULLUP);
+	uint32_t now;
+	if (readTime(now))
+		seconds = now;
+	tickMillis = millis();
+	readTemperature();
+	attachInterrupt(digitalPinToInterrupt(RTC_SQW_PIN), sqwIsr, FALLING);
+}
+
+/*****************************************************************************/
+/* adjust()                                                                  */
+/*****************************************************************************/
+void RtcClock::adjust(const DateTime &dt) {
+	rtc->adjust(dt);
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		seconds = dt.unixtime();
+		tickMillis = millis();
+		synced = true;
+	}
+}
+
+/*****************************************************************************/
+/* tickIsr()                                                                 */
+/*****************************************************************************/
+void RtcClock::tickIsr() {
+	seconds++;
+	tickMillis = millis();
+	ticked = true;
+}
+
+/*****************************************************************************/
+/* pending()                                                                 */
+/*****************************************************************************/
+bool RtcClock::pending() {
+	return ticked && !synced;
+}
+
+/*****************************************************************************/
+/* refresh()                                                                 */
+/* A leitura da hora acontece poucos milissegundos depois do pulso, bem      */
+/* antes do seguinte: o segundo lido é o que começou no pulso. Na leitura da */
+/* temperatura, a hora volta a ficar pendente: o pulso seguinte traz uma     */
+/* nova leitura, que corrige pulsos perdidos e o acerto feito por fora.      */
+/*****************************************************************************/
+void RtcClock::refresh() {
+	if (pending()) {
+		uint32_t now;
+		if (readTime(now)) {
+			ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+				seconds = now;
+			}
+		}
+		synced = true;  // Uma falha só é tentada de novo depois da próxima temperatura
+		return;
+	}
+	readTemperature();
+	ticked = false;
+	synced = false;
+}
+
+/*****************************************************************************/
+/* BCD, como o DS3231 guarda a data e a hora, para binário.                  */
+/*****************************************************************************/
+static byte bcd2bin(byte value) {
+	return value - 6 * (value >> 4);
+}
+
+/*****************************************************************************/
+/* readTime()                                                                */
+/* O RTClib grava as horas no modo de 24 horas. Uma falha, ou um dia ou mês  */
+/* impossível, mantém a hora anterior.                                       */
+/*****************************************************************************/
+bool RtcClock::readTime(uint32_t &unixtime) {
+	byte raw[7];
+	if (!i2c.read(DS3231_I2C_ADDRESS, DS3231_TIME, raw, sizeof(raw)))
+		return false;
+	byte day = bcd2bin(raw[4] & 0x3F);
+	byte month = bcd2bin(raw[5] & 0x1F);
+	if (day < 1 || day > 31 || month < 1 || month > 12)
+		return false;
+	DateTime dt(2000 + bcd2bin(raw[6]), month, day,
+	            bcd2bin(raw[2] & 0x3F), bcd2bin(raw[1] & 0x7F), bcd2bin(raw[0] & 0x7F));
+	unixtime = dt.unixtime();
+	return true;
+}
+
+/*****************************************************************************/
+/* readTemperature()                                                         */
+/* Complemento de dois em 10 bits: parte inteira com sinal no primeiro byte, */
+/* quartos de grau nos bits 7 e 6 do segundo. Uma falha mantém o valor       */
+/* anterior.                                                                 */
+/*****************************************************************************/
+void RtcClock::readTemperature() {
+	byte raw[2];
+	if (i2c.read(DS3231_I2C_ADDRESS, DS3231_TEMPERATURE_MSB, raw, sizeof(raw)))
+		temperature = (int8_t) raw[0] * 100 + (raw[1] >> 6) * 25;
+}
+
+/*****************************************************************************/
+/* unixtime()                                                                */
+/* Sem pulsos há mais de um segundo, os segundos que faltam vêm do millis(). */
+/*****************************************************************************/
+uint32_t RtcClock::unixtime(uint16_t *fraction) {
+	uint32_t s;
+	unsigned long tick;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		s = seconds;
+		tick = tickMillis;
+	}
+	unsigned long elapsed = millis() - tick;
+	if (fraction != NULL)
+		*fraction = elapsed % 1000;
+	return s + elapsed / 1000;
+}
+
+/*****************************************************************************/
+/* Escreve value com width dígitos, completando com zeros à esquerda.        */
+/*****************************************************************************/
+static char *appendDigits(char *p, unsigned int value, byte width) {
+	for (byte i = width; i > 0; i--) {
+		p[i - 1] = '0' + value % 10;
+		value /= 10;
+	}
+	return p + width;
+}
+
+/*****************************************************************************/
+/* formatTime()                                                              */
+/*****************************************************************************/
+char *RtcClock::formatTime(char *out) {
+	DateTime now(unixtime());
+	out = appendDigits(out, now.year(), 4);
+	*out++ = ':';
+	out = appendDigits(out, now.month(), 2);
+	*out++ = ':';
+	out = appendDigits(out, now.day(), 2);
+	*out++ = ':';
+	out = appendDigits(out, now.hour(), 2);
+	*out++ = ':';
+	out = appendDigits(out, now.minute(), 2);
+	*out++ = ':';
+	out = appendDigits(out, now.second(), 2);
+	*out = '\0';
+	return out;
+}
+
+/*****************************************************************************/
+/* formatTemperature()                                                       */
+/*****************************************************************************/
+char *RtcClock::formatTemperature(char *out) {
+	int t = temperature;
+	if (t < 0) {
+		*out++ = '-';
+		t = -t;
+	}
+	utoa(t / 100, out, 10);
+	out += strlen(out);
+	*out++ = '.';
+	out = appendDigits(out, t % 100, 2);
+	*out = '\0';
+	return out;
+}
@@ -0,0 +1,116 @@
+#ifndef RTCCLOCK_H
+#define RTCCLOCK_H
+
+#include <Arduino.h>
+#include <RTClib.h>
+#include "config.h"
+
+#define DS3231_I2C_ADDRESS      0x68  /**< Endereço do DS3231 no barramento. */
+#define DS3231_TIME             0x00  /**< Segundos; seguem minutos, horas, dia da semana, dia, mês e ano, em BCD. */
+#define DS3231_TEMPERATURE_MSB  0x11  /**< Parte inteira da temperatura; o registrador seguinte traz os quartos de grau. */
+
+/**
+ * @class RtcClock
+ * @brief Data, hora e temperatura do DS3231 mantidas em RAM.
+ *
+ * A saída SQW do DS3231 gera 1 Hz em `RTC_SQW_PIN`. A interrupção da borda
+ * de descida, quando o DS3231 avança os segundos, soma um segundo ao relógio
+ * em RAM e guarda o `millis()` do instante, que dá a fração do segundo.
+ * Assim o GETTIME é respondido sem nenhuma transação I2C.
+ *
+ * O barramento só é usado fora do tratamento dos comandos, por `refresh()`:
+ * - depois do primeiro pulso após `begin()`, para ler a hora já alinhada
+ *   com o pulso;
+ * - a cada `RTC_TEMPERATURE_PERIOD`, para ler a temperatura, que o DS3231
+ *   só converte a cada 64 s;
+ * - no pulso seguinte a cada leitura da temperatura, para reler a hora. Um
+ *   pulso perdido não deixa o relógio em RAM atrasado por mais que isso.
+ *
+ * Sem pulsos (SQW desligado), o relógio continua andando pelo `millis()`.
+ *
+ * As leituras da hora e da temperatura passam por `i2c.read()`, e entram
+ * nos contadores do barramento; o RTClib só é usado para o SQW e o acerto.
+ */
+class RtcClock {
+	public:
+		/**
+		* @brief Temperatura em centésimos de grau Celsius (resolução do DS3231: 25).
+		*/
+		int temperature;
+
+		RtcClock();
+
+		/**
+		* @brief Liga o SQW em 1 Hz, lê a hora e a temperatura e liga a interrupção.
+		*
+		* Até o primeiro pulso a fração do segundo é desconhecida (erro de até 1 s).
+		*
+		* @param rtc DS3231 já iniciado (`rtc.begin()`).
+		*/
+		void begin(RTC_DS3231 &rtc);
+
+		/**
+		* @brief Acerta o DS3231 e o relógio em RAM.
+		*
+		* A escrita dos segundos zera a contagem do DS3231: o próximo pulso vem
+		* um segundo depois, já alinhado.
+		*/
+		void adjust(const DateTime &dt);
+
+		/**
+		* @brief Indica se `refresh()` precisa rodar para alinhar a hora com o pulso.
+		*/
+		bool pending();
+
+		/**
+		* @brief Lê do DS3231 a hora alinhada, se `pending()`, ou então a temperatura.
+		*
+		* Depois da temperatura a hora volta a ficar pendente até o próximo pulso.
+		*/
+		void refresh();
+
+		/**
+		* @brief Segundos desde 1970, sem I2C.
+		*
+		* @param[out] fraction Se não nulo, recebe a fração do segundo em milissegundos.
+		*/
+		uint32_t unixtime(uint16_t *fraction = NULL);
+
+		/**
+		* @brief Escreve `YYYY:MM:DD:HH:MM:SS`, sem `sprintf()`.
+		*
+		* @param out Destino, com pelo menos 20 bytes.
+		* @return Fim da string escrita (o `'\0'`).
+		*/
+		char *formatTime(char *out);
+
+		/**
+		* @brief Escreve `temperature` em graus com duas casas (`25.75`, `-3.25`), sem `dtostrf()`.
+		*
+		* @param out Destino, com pelo menos 8 bytes.
+		* @return Fim da string escrita (o `'\0'`).
+		*/
+		char *formatTemperature(char *out);
+
+		/**
+		* @brief Tratamento da interrupção do SQW; chamado somente pela rotina ligada em `begin()`.
+		*/
+		void tickIsr();
+
+	private:
+		RTC_DS3231 *rtc;
+		volatile uint32_t seconds;        // Hora do último pulso
+		volatile unsigned long tickMillis; // millis() do último pulso
+		volatile bool ticked;             // Houve pulso desde begin() ou desde a última temperatura
+		bool synced;                      // `seconds` foi lido depois de um pulso, desde a última temperatura
+		bool readTime(uint32_t &unixtime);
+		void readTemperature();
+};
+
+/**
+ * @var RtcClock rtcClock
+ * @brief Instância única, ligada ao DS3231 e à interrupção de `RTC_SQW_PIN`.
+ */
+extern RtcClock rtcClock;
+
+#endif // RTCCLOCK_H
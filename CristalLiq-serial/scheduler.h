@@ -0,0 +1,136 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
+
+/**
+ * @class Scheduler
+ * @brief Escalonador cooperativo com uma tabela fixa de tarefas.
+ *
+ * Cada tarefa é uma função sem parâmetros que roda até o fim. Ela fica
+ * pronta quando alguém a acorda (`wake()`, por exemplo ao chegar um byte
+ * na serial) ou quando vence o prazo marcado com `at()` ou `after()`.
+ * A posição na tabela é a prioridade: `run()` executa só a primeira tarefa
+ * pronta, e a próxima chamada volta a olhar a tabela desde o início. Assim
+ * uma tarefa de índice baixo espera no máximo a tarefa que já está rodando.
+ *
+ * Sem tarefa pronta, `idle()` põe o processador em `SLEEP_MODE_IDLE` até a
+ * próxima interrupção: a da recepção serial ou a do `millis()`, a cada 1 ms.
+ *
+ * @tparam N Número de tarefas, no máximo 8.
+ */
+template <byte N>
+class Scheduler {
+	static_assert(N >= 1 && N <= 8, "N deve estar entre 1 e 8");
+	public:
+		/**
+		* @brief Função de uma tarefa.
+		*/
+		typedef void (*Task)();
+
+		/**
+		* @brief Maior duração já observada de cada tarefa, em microssegundos.
+		*
+		* O pior tempo de resposta de uma tarefa é a soma da maior duração
+		* entre as demais (a que pode estar rodando quando ela fica pronta) e
+		* da sua própria.
+		*/
+		unsigned long longest[N];
+
+		/**
+		* @brief Chamadas de `run()` desde o reset, uma por passada do `loop()`.
+		*/
+		unsigned long passes;
+
+		/**
+		* @param table Funções das tarefas, em PROGMEM, na ordem de prioridade.
+		*/
+		explicit Scheduler(const Task *table) : passes(0), table(table), ready(0), timed(0) {
+			memset(longest, 0, sizeof(longest));
+		}
+
+		/**
+		* @brief Torna a tarefa pronta. Pode ser chamada de uma interrupção.
+		*/
+		void wake(byte id) {
+			ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+				ready |= _BV(id);
+			}
+		}
+
+		/**
+		* @brief Marca o instante (em `millis()`) em que a tarefa fica pronta.
+		*
+		* Substitui o prazo anterior, se havia.
+		*/
+		void at(byte id, unsigned long when) {
+			due[id] = when;
+			timed |= _BV(id);
+		}
+
+		/**
+		* @brief Marca o prazo da tarefa a `delay` milissegundos de agora.
+		*/
+		void after(byte id, unsigned long delay) { at(id, millis() + delay); }
+
+		/**
+		* @brief Desfaz o prazo da tarefa, sem mexer num `wake()` já feito.
+		*/
+		void cancel(byte id) { timed &= ~_BV(id); }
+
+		/**
+		* @brief Executa a tarefa pronta de maior prioridade.
+		*
+		* Um prazo vencido torna a tarefa pronta e é descartado: a própria
+		* tarefa marca o próximo, se quiser rodar de novo.
+		*
+		* @return `false` se nenhuma tarefa estava pronta.
+		*/
+		bool run() {
+			unsigned long now = millis();
+			passes++;
+			for (byte i = 0; i < N; i++) {
+				byte bit = _BV(i);
+				if ((timed & bit) && (long) (now - due[i]) >= 0) {
+					timed &= ~bit;
+					wake(i);
+				}
+				if (!(ready & bit))
+					continue;
+				ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+					ready &= ~bit;
+				}
+				Task task = (Task) pgm_read_ptr(&table[i]);
+				unsigned long start = micros();
+				task();
+				unsigned long spent = micros() - start;
+				if (spent > longest[i])
+					longest[i] = spent;
+				return true;
+			}
+			return false;
+		}
+
+		/**
+		* @brief Dorme até a próxima interrupção.
+		*
+		* Um byte que chegue entre a última verificação e o `sleep_cpu()`
+		* espera no máximo a interrupção seguinte do `millis()`.
+		*/
+		void idle() {
+			set_sleep_mode(SLEEP_MODE_IDLE);
+			sleep_enable();
+			sleep_cpu();
+			sleep_disable();
+		}
+
+	private:
+		const Task *table;     // PROGMEM
+		volatile byte ready;   // Um bit por tarefa acordada
+		byte timed;            // Um bit por tarefa com prazo em `due`
+		unsigned long due[N];
+};
+
+#endif // SCHEDULER_H
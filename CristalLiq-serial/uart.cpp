@@ -0,0 +1,136 @@
+#include "uart.h"
+
+#ifdef USE_NATIVE_UART
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "frame.h"
+
+NativeUart uart;
+
+/*****************************************************************************/
+/* Construtor                                                                */
+/*****************************************************************************/
+NativeUart::NativeUart() : rxOverruns(0), decoder(NULL), written(false)
+{
+}
+
+/*****************************************************************************/
+/* begin()                                                                   */
+/* Usa o modo de velocidade dupla (U2X0), com a mesma fórmula do núcleo      */
+/* Arduino, que erra menos nas taxas altas a 16 MHz.                         */
+/*****************************************************************************/
+void NativeUart::begin(unsigned long baudRate) {
+	uint16_t ubrr = (F_CPU / 4 / baudRate - 1) / 2;
+	UCSR0B = 0;
+	UCSR0A = _BV(U2X0);
+	UBRR0H = ubrr >> 8;
+	UBRR0L = ubrr;
+	UCSR0C = _BV(UCSZ01) | _BV(UCSZ00);
+	UCSR0B = _BV(RXEN0) | _BV(TXEN0) | _BV(RXCIE0);
+	written = false;
+}
+
+int NativeUart::available() {
+	return rx.count();
+}
+
+int NativeUart::read() {
+	uint8_t c;
+	if (!rx.pop(c))
+		return -1;
+	return c;
+}
+
+int NativeUart::peek() {
+	uint8_t *c = rx.front();
+	return c == NULL ? -1 : *c;
+}
+
+/*****************************************************************************/
+/* write()                                                                   */
+/* Com a linha ociosa o byte vai direto ao registrador, como no núcleo       */
+/* Arduino. Se a fila estiver cheia com as interrupções desligadas, ninguém  */
+/* a esvaziaria: a própria write() faz o papel da interrupção UDRE.          */
+/* Cada escrita em UDR0 limpa TXC0 (escrevendo 1), para flush() saber        */
+/* quando o último byte terminou de sair.                                    */
+/*****************************************************************************/
+size_t NativeUart::write(uint8_t c) {
+	written = true;
+	if (tx.empty() && (UCSR0A & _BV(UDRE0))) {
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+			UDR0 = c;
+			UCSR0A = (UCSR0A & _BV(U2X0)) | _BV(TXC0);
+		}
+		return 1;
+	}
+	while (!tx.push(c)) {
+		if (!(SREG & _BV(SREG_I)) && (UCSR0A & _BV(UDRE0)))
+			udreIsr();
+	}
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		UCSR0B |= _BV(UDRIE0);
+	}
+	return 1;
+}
+
+int NativeUart::availableForWrite() {
+	return TX_BUFFER_SIZE - 1 - tx.count();
+}
+
+int NativeUart::pending() {
+	return tx.count();
+}
+
+void NativeUart::flush() {
+	if (!written)
+		return;
+	while (!tx.empty() || !(UCSR0A & _BV(TXC0)))
+		;
+}
+
+/*****************************************************************************/
+/* rxIsr()                                                                   */
+/* O registrador de status deve ser lido antes de UDR0, que limpa os flags.  */
+/*****************************************************************************/
+void NativeUart::rxIsr() {
+	bool lost = UCSR0A & _BV(DOR0);
+	uint8_t c = UDR0;
+	if (lost)
+		rxOverruns++;
+#ifdef RX_ISR_DECODE
+	if (decoder != NULL) {
+		decoder->decodeByte(c);
+		return;
+	}
+#endif
+	if (!rx.push(c))
+		rxOverruns++;
+}
+
+/*****************************************************************************/
+/* udreIsr()                                                                 */
+/* Desliga a própria interrupção quando não há mais o que transmitir.        */
+/*****************************************************************************/
+void NativeUart::udreIsr() {
+	uint8_t c;
+	if (tx.pop(c)) {
+		UDR0 = c;
+		UCSR0A = (UCSR0A & _BV(U2X0)) | _BV(TXC0);
+	}
+	if (tx.empty())
+		UCSR0B &= ~_BV(UDRIE0);
+}
+
+ISR(USART_RX_vect)
+{
+	uart.rxIsr();
+}
+
+ISR(USART_UDRE_vect)
+{
+	uart.udreIsr();
+}
+
+#endif // USE_NATIVE_UART
@@ -0,0 +1,102 @@
+#ifndef UART_H
+#define UART_H
+
+#include "config.h"
+
+#ifdef USE_NATIVE_UART
+
+#include <Arduino.h>
+#include "ringbuffer.h"
+
+class SerialProtocol;
+
+/**
+ * @class NativeUart
+ * @brief Driver da USART0 do ATmega328P com recepção e transmissão por interrupção.
+ *
+ * A interrupção de RX tira o byte do registrador e o guarda na fila `rx`;
+ * o `loop()` consome pela interface `Stream`, como faria com a `Serial`.
+ * Na transmissão, `write()` só enfileira em `tx`, e a interrupção UDRE
+ * entrega cada byte à USART quando o registrador esvazia.
+ * Se houver um decodificador associado (opção `RX_ISR_DECODE`), o byte vai
+ * direto para a máquina de recepção, ainda dentro da interrupção.
+ */
+class NativeUart : public Stream {
+	public:
+		/**
+		* @brief Fila de bytes recebidos, da interrupção para o `loop()`.
+		*/
+		RingBuffer<uint8_t, RX_BUFFER_SIZE> rx;
+
+		/**
+		* @brief Fila de bytes a transmitir, do `loop()` para a interrupção UDRE.
+		*/
+		RingBuffer<uint8_t, TX_BUFFER_SIZE> tx;
+
+		/**
+		* @brief Bytes perdidos por fila cheia ou por estouro no registrador da USART.
+		*/
+		volatile unsigned int rxOverruns;
+
+		/**
+		* @brief Quando não nulo, recebe cada byte dentro da interrupção.
+		*/
+		SerialProtocol *decoder;
+
+		/**
+		* @brief Algum byte foi escrito desde o último `begin()`; usado por `flush()`.
+		*/
+		volatile bool written;
+
+		NativeUart();
+
+		/**
+		* @brief Configura a USART0 em 8N1 na taxa pedida e liga a recepção por interrupção.
+		*
+		* @param baudRate Taxa em bauds.
+		*/
+		void begin(unsigned long baudRate);
+
+		int available();
+		int read();
+		int peek();
+		/**
+		* @brief Enfileira um byte para transmissão.
+		*
+		* Só espera se a fila `tx` estiver cheia.
+		*/
+		size_t write(uint8_t c);
+		using Print::write;
+		/**
+		* @brief Espaço livre na fila de transmissão.
+		*/
+		int availableForWrite();
+		/**
+		* @brief Bytes enfileirados que ainda não saíram pela linha.
+		*/
+		int pending();
+		/**
+		* @brief Espera a fila de transmissão esvaziar e o último byte sair da USART.
+		*/
+		void flush();
+
+		/**
+		* @brief Tratamento da interrupção de RX; chamado somente pelo vetor USART_RX_vect.
+		*/
+		void rxIsr();
+
+		/**
+		* @brief Tratamento da interrupção UDRE; chamado somente pelo vetor USART_UDRE_vect.
+		*/
+		void udreIsr();
+};
+
+/**
+ * @var NativeUart uart
+ * @brief Instância única, ligada à USART0.
+ */
+extern NativeUart uart;
+
+#endif // USE_NATIVE_UART
+
+#endif // UART_H
@@ -0,0 +1,104 @@
+#include "utf8.h"
+
+// Código Unicode de cada caractere de 0x80 a 0x9F do Windows-1252; 0 nas posições sem caractere
+static const uint16_t win1252High[32] PROGMEM = {
+    /* 0x80–0x87 */ 0x20AC, 0,      0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+    /* 0x88–0x8F */ 0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0,      0x017D, 0,
+    /* 0x90–0x97 */ 0,      0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    /* 0x98–0x9F */ 0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0,      0x017E, 0x0178
+};
+
+/*****************************************************************************/
+/* unicodeToWin1252()                                                        */
+/* Os controles C1 (U+0080 a U+009F) não têm equivalente e são trocados.     */
+/*****************************************************************************/
+char unicodeToWin1252(uint16_t cp) {
+	if (cp < 0x80 || (cp >= 0xA0 && cp <= 0xFF))
+		return cp;
+	if (cp > 0xFF) {
+		for (byte i = 0; i < 32; i++) {
+			if (pgm_read_word(&win1252High[i]) == cp)
+				return 0x80 + i;
+		}
+	}
+	return UTF8_REPLACEMENT;
+}
+
+/*****************************************************************************/
+/* decode()                                                                  */
+/* C0, C1 e F5 a FF nunca aparecem em UTF-8 válido. O primeiro byte de       */
+/* continuação tem faixa própria depois de E0, ED, F0 e F4, o que recusa as  */
+/* formas longas, os substitutos (U+D800 a U+DFFF) e o que passa de          */
+/* U+10FFFF; fora da faixa, a sequência termina ali e o byte vira outro      */
+/* UTF8_REPLACEMENT. As sequências de 4 bytes (acima de U+FFFF) são          */
+/* consumidas inteiras e viram um só UTF8_REPLACEMENT.                       */
+/*****************************************************************************/
+byte Utf8Decoder::decode(unsigned char b, char *out) {
+	byte n = 0;
+	if ((b & 0xC0) == 0x80) {            // Continuação
+		if (pending != 0 && b >= lower && b <= upper) {
+			lower = 0x80;
+			upper = 0xBF;
+			if (codePoint != 0xFFFF)
+				codePoint = (codePoint << 6) | (b & 0x3F);
+			if (--pending != 0)
+				return 0;
+			out[0] = unicodeToWin1252(codePoint);
+			return 1;
+		}
+		if (pending != 0) {              // Forma longa, substituto ou acima de U+10FFFF
+			out[n++] = UTF8_REPLACEMENT;
+			pending = 0;
+		}
+		out[n++] = UTF8_REPLACEMENT;
+		return n;
+	}
+	if (pending != 0) {                  // Sequência interrompida
+		out[n++] = UTF8_REPLACEMENT;
+		pending = 0;
+	}
+	lower = 0x80;
+	upper = 0xBF;
+	if (b < 0x80)
+		out[n++] = b;
+	else if (b >= 0xC2 && b <= 0xDF) {
+		pending = 1;
+		codePoint = b & 0x1F;
+	}
+	else if (b >= 0xE0 && b <= 0xEF) {
+		pending = 2;
+		codePoint = b & 0x0F;
+		if (b == 0xE0)
+			lower = 0xA0;                // Abaixo de U+0800
+		else if (b == 0xED)
+			upper = 0x9F;                // U+D800 a U+DFFF
+	}
+	else if (b >= 0xF0 && b <= 0xF4) {
+		pending = 3;
+		codePoint = 0xFFFF;
+		if (b == 0xF0)
+			lower = 0x90;                // Abaixo de U+10000
+		else if (b == 0xF4)
+			upper = 0x8F;                // Acima de U+10FFFF
+	}
+	else
+		out[n++] = UTF8_REPLACEMENT;
+	return n;
+}
+
+/*****************************************************************************/
+/* utf8ToWin1252()                                                           */
+/* A escrita nunca passa a leitura: cada caractere produzido consome pelo    */
+/* menos um byte, e os dois de uma sequência interrompida (ou recusada no    */
+/* byte de continuação) consomem pelo menos dois.                            */
+/*****************************************************************************/
+byte utf8ToWin1252(char *str, byte size) {
+	Utf8Decoder utf8;
+	byte out = 0;
+	for (byte i = 0; i < size; i++)
+		out += utf8.decode(str[i], str + out);
+	if (utf8.incomplete())
+		str[out++] = UTF8_REPLACEMENT;
+	str[out] = '\0';
+	return out;
+}
@@ -0,0 +1,84 @@
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <Arduino.h>
+
+/**
+ * @file utf8.h
+ * @brief Conversão de texto UTF-8 para Windows-1252, o conjunto usado no resto do firmware.
+ *
+ * Os códigos de U+00A0 a U+00FF são os mesmos nas duas codificações; os
+ * sinais tipográficos de 0x80 a 0x9F (aspas curvas, travessão, reticências,
+ * euro etc.) são procurados numa tabela de 32 entradas em PROGMEM. O que não
+ * existe em Windows-1252 vira `UTF8_REPLACEMENT`, e daí em diante segue o
+ * caminho de qualquer caractere: glifo na CGRAM ou equivalente sem acento.
+ */
+
+#define UTF8_REPLACEMENT '?'  /**< Posto no lugar de sequências inválidas e de caracteres fora do Windows-1252. */
+
+/**
+ * @class Utf8Decoder
+ * @brief Decodificador incremental: recebe um byte por vez, como chegam da serial.
+ *
+ * Guarda só os bytes de continuação que faltam e o código em montagem, o
+ * que permite usá-lo dentro da máquina de recepção, inclusive na
+ * interrupção de RX. É tolerante: um byte inesperado no meio de uma
+ * sequência a encerra com `UTF8_REPLACEMENT` e é tratado normalmente.
+ *
+ * É também estrito: formas longas (como `E0 81 BC` para '|'), substitutos
+ * (U+D800 a U+DFFF) e códigos acima de U+10FFFF viram `UTF8_REPLACEMENT`,
+ * para nenhum byte fora do ASCII virar um delimitador do protocolo.
+ */
+class Utf8Decoder {
+	public:
+		Utf8Decoder() : pending(0), codePoint(0), lower(0x80), upper(0xBF) {}
+
+		/**
+		* @brief Descarta a sequência em andamento.
+		*/
+		void reset() { pending = 0; }
+
+		/**
+		* @brief Indica se há uma sequência começada e não terminada.
+		*/
+		bool incomplete() const { return pending != 0; }
+
+		/**
+		* @brief Passa um byte pelo decodificador.
+		*
+		* @param b   Byte recebido.
+		* @param out Onde os caracteres Windows-1252 produzidos são escritos (até 2).
+		* @return Quantidade de caracteres escritos em `out`: 0 no meio de uma
+		*         sequência, 2 quando uma sequência é interrompida por um byte ASCII
+		*         ou por um byte de continuação fora da faixa permitida.
+		*/
+		byte decode(unsigned char b, char *out);
+
+	private:
+		byte pending;         // Bytes de continuação que faltam
+		uint16_t codePoint;   // 0xFFFF nas sequências de 4 bytes, que não cabem no display
+		byte lower;           // Faixa aceita para o próximo byte de continuação
+		byte upper;
+};
+
+/**
+ * @brief Converte um código Unicode no caractere Windows-1252 correspondente.
+ *
+ * @param cp Código (até U+FFFF).
+ * @return O caractere, ou `UTF8_REPLACEMENT` se não houver equivalente.
+ */
+char unicodeToWin1252(uint16_t cp);
+
+/**
+ * @brief Converte no lugar um trecho UTF-8 já recebido por inteiro.
+ *
+ * Usada quando os bytes precisam chegar intactos até a conferência do CRC.
+ * O resultado nunca é maior que a entrada e termina com `'\0'`.
+ *
+ * @param str  Texto; `str[size]` precisa poder receber o `'\0'`.
+ * @param size Quantidade de bytes em `str`.
+ * @return Tamanho do texto convertido.
+ */
+byte utf8ToWin1252(char *str, byte size);
+
+#endif // UTF8_H
@@ -0,0 +1,22 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include "bench.h"
+
+/*****************************************************************************/
+/* Saída das medições no terminal.                                           */
+/*****************************************************************************/
+class StdoutPrint : public Print {
+	public:
+		size_t write(uint8_t c) { return putchar(c) == EOF ? 0 : 1; }
+		using Print::write;
+};
+
+/*****************************************************************************/
+/* As mesmas medições do setup() com BENCHMARK, com os tempos do PC em ns/B: */
+/* os ciclos da placa só são medidos nela.                                   */
+/*****************************************************************************/
+int main(int argc, char **argv) {
+	StdoutPrint out;
+	runBenchmarks(out, argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000UL);
+	return 0;
+}
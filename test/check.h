@@ -0,0 +1,32 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+/**
+ * @file check.h
+ * @brief Verificações dos testes no PC: cada falha é impressa e o `main()` devolve o total.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+static int checkFailures = 0;
+
+#define CHECK(cond) do { \
+		if (!(cond)) { \
+			fprintf(stderr, "%s:%d: falhou: %s\n", __FILE__, __LINE__, #cond); \
+			checkFailures++; \
+		} \
+	} while (0)
+
+#define CHECK_STR(got, expected) do { \
+		const char *checkGot = (got); \
+		const char *checkExpected = (expected); \
+		if (strcmp(checkGot, checkExpected) != 0) { \
+			fprintf(stderr, "%s:%d: falhou: \"%s\" != \"%s\"\n", __FILE__, __LINE__, checkGot, checkExpected); \
+			checkFailures++; \
+		} \
+	} while (0)
+
+#define CHECK_RESULT() (checkFailures == 0 ? 0 : 1)
+
+#endif // CHECK_H
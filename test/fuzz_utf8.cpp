@@ -0,0 +1,109 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include "utf8.h"
+
+/**
+ * @file fuzz_utf8.cpp
+ * @brief Fuzzing da conversão UTF-8: `LLVMFuzzerTestOneInput()` para o libFuzzer
+ * (opção `FUZZ_LIBFUZZER`) e, sem ele, um `main()` com entradas aleatórias.
+ *
+ * Para cada entrada confere que:
+ * - `utf8ToWin1252()` (no lugar) e `Utf8Decoder::decode()` (byte a byte) dão o mesmo texto;
+ * - o texto convertido não é maior que a entrada;
+ * - os caracteres ASCII da saída, tirando `UTF8_REPLACEMENT`, são exatamente
+ *   os bytes ASCII da entrada, na mesma ordem: nenhuma sequência longa ou
+ *   inválida produz um '<', '|' ou '>' que não veio como tal.
+ */
+
+/*****************************************************************************/
+/* Bytes ASCII de um texto, sem UTF8_REPLACEMENT.                            */
+/*****************************************************************************/
+static size_t asciiOf(const uint8_t *data, size_t size, char *out) {
+	size_t n = 0;
+	for (size_t i = 0; i < size; i++)
+		if (data[i] < 0x80 && data[i] != UTF8_REPLACEMENT)
+			out[n++] = data[i];
+	return n;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+	if (size > 255)   // utf8ToWin1252() trabalha com tamanhos de um byte
+		size = 255;
+	char str[256];
+	memcpy(str, data, size);
+	byte n = utf8ToWin1252(str, size);
+
+	char incremental[512];
+	size_t m = 0;
+	Utf8Decoder utf8;
+	for (size_t i = 0; i < size; i++) {
+		byte produced = utf8.decode(data[i], incremental + m);
+		if (produced > 2)
+			abort();
+		m += produced;
+	}
+	if (utf8.incomplete())
+		incremental[m++] = UTF8_REPLACEMENT;
+	if (m != n || memcmp(incremental, str, n) != 0 || str[n] != '\0')
+		abort();
+	if (n > size)
+		abort();
+
+	char in[256], out[256];
+	size_t inAscii = asciiOf(data, size, in);
+	size_t outAscii = asciiOf((const uint8_t *) str, n, out);
+	if (inAscii != outAscii || memcmp(in, out, inAscii) != 0)
+		abort();
+	return 0;
+}
+
+#ifndef FUZZ_LIBFUZZER
+
+/*****************************************************************************/
+/* Gerador xorshift32: sequência fixa, para uma falha poder ser repetida.    */
+/*****************************************************************************/
+static uint32_t seed = 2463534242UL;
+
+static uint32_t next() {
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	return seed;
+}
+
+/*****************************************************************************/
+/* Bytes sorteados com peso nas bordas das faixas do UTF-8, onde estão as    */
+/* formas longas, os substitutos e o limite de U+10FFFF.                     */
+/*****************************************************************************/
+static uint8_t randomByte() {
+	static const uint8_t edges[] = {
+		'<', '|', '>', '?', 'a', 0x00, 0x7F,
+		0x80, 0x8F, 0x90, 0x9F, 0xA0, 0xBC, 0xBE, 0xBF,
+		0xC0, 0xC1, 0xC2, 0xC3, 0xDF, 0xE0, 0xE2, 0xED, 0xEE, 0xEF,
+		0xF0, 0xF1, 0xF4, 0xF5, 0xFF
+	};
+	uint32_t r = next();
+	if (r & 1)
+		return edges[(r >> 1) % sizeof(edges)];
+	return r >> 8;
+}
+
+/**
+ * @brief Roda `LLVMFuzzerTestOneInput()` com entradas aleatórias.
+ *
+ * @param argc, argv Quantidade de entradas (200000 se omitida).
+ */
+int main(int argc, char *argv[]) {
+	unsigned long runs = argc > 1 ? strtoul(argv[1], NULL, 10) : 200000UL;
+	uint8_t data[64];
+	for (unsigned long i = 0; i < runs; i++) {
+		size_t size = next() % sizeof(data);
+		for (size_t j = 0; j < size; j++)
+			data[j] = randomByte();
+		LLVMFuzzerTestOneInput(data, size);
+	}
+	printf("%lu entradas, nenhuma falha\n", runs);
+	return 0;
+}
+
+#endif
@@ -0,0 +1,204 @@
+#ifndef HD44780_MODEL_H
+#define HD44780_MODEL_H
+
+#include <Arduino.h>
+
+/**
+ * @class Hd44780Model
+ * @brief Modelo de um controlador HD44780: instruções, DDRAM, CGRAM e _busy flag_.
+ *
+ * Recebe bytes inteiros (`write()`, como num barramento de 8 bits), nibbles
+ * (`nibble()`, nas linhas D4..D7) ou o byte de um PCF8574 (`pcf()`, como o
+ * módulo I2C do LCD). Depois de ligar está em 8 bits; um _function set_ sem
+ * o bit DL passa a interface para 4 bits, como no controlador real.
+ *
+ * As instruções recebidas ficam em `log`, para conferir a inicialização.
+ */
+class Hd44780Model {
+	public:
+		enum { LOG_SIZE = 32, DDRAM_SIZE = 0x80, CGRAM_SIZE = 64 };
+
+		byte ddram[DDRAM_SIZE];
+		byte cgram[CGRAM_SIZE];
+		byte address;            /**< Contador de endereço. */
+		bool cgramSelected;      /**< O contador aponta para a CGRAM. */
+		bool fourBit;            /**< Interface de 4 bits. */
+		byte functionSet;        /**< Último _function set_. */
+		byte displayControl;     /**< Último _display control_. */
+		byte entryMode;          /**< Último _entry mode set_. */
+		byte log[LOG_SIZE];      /**< Instruções recebidas, até `LOG_SIZE`. */
+		byte logSize;
+		byte busyReads;          /**< Leituras do _busy flag_ que ainda dão ocupado. */
+
+		Hd44780Model() { reset(); }
+
+		/**
+		* @brief Estado ao ligar: interface de 8 bits, uma linha, tela em branco.
+		*/
+		void reset() {
+			memset(ddram, ' ', sizeof(ddram));
+			memset(cgram, 0, sizeof(cgram));
+			address = 0;
+			cgramSelected = false;
+			fourBit = false;
+			functionSet = 0x30;
+			displayControl = 0x08;
+			entryMode = 0x06;
+			logSize = 0;
+			busyReads = 0;
+			highNibble = -1;
+			lastPcf = 0;
+		}
+
+		/**
+		* @brief Executa um byte de instrução (`rs` falso) ou de dado.
+		*/
+		void write(byte value, bool rs) {
+			busyReads = 1;
+			if (rs) {
+				if (cgramSelected) {
+					cgram[address & (CGRAM_SIZE - 1)] = value;
+					address = (address + 1) & (CGRAM_SIZE - 1);
+				}
+				else {
+					ddram[address] = value;
+					advance();
+				}
+				return;
+			}
+			if (logSize < LOG_SIZE)
+				log[logSize++] = value;
+			if (value & 0x80) {
+				cgramSelected = false;
+				address = value & 0x7F;
+			}
+			else if (value & 0x40) {
+				cgramSelected = true;
+				address = value & 0x3F;
+			}
+			else if (value & 0x20) {
+				functionSet = value;
+				fourBit = !(value & 0x10);
+			}
+			else if (value & 0x08)
+				displayControl = value;
+			else if (value & 0x04)
+				entryMode = value;
+			else if (value & 0x02) {
+				cgramSelected = false;
+				address = 0;
+				busyReads = 3;
+			}
+			else if (value == 0x01) {
+				memset(ddram, ' ', sizeof(ddram));
+				cgramSelected = false;
+				address = 0;
+				entryMode |= 0x02;
+				busyReads = 3;
+			}
+		}
+
+		/**
+		* @brief Recebe o nibble alto de `value` nas linhas D4..D7.
+		*
+		* Em 8 bits as linhas D0..D3 ficam em zero e o nibble já é uma instrução
+		* completa; em 4 bits é preciso juntar dois.
+		*/
+		void nibble(byte value, bool rs) {
+			if (!fourBit) {
+				write(value & 0xF0, rs);
+				return;
+			}
+			if (highNibble < 0) {
+				highNibble = value & 0xF0;
+				return;
+			}
+			byte full = highNibble | (value >> 4);
+			highNibble = -1;
+			write(full, rs);
+		}
+
+		/**
+		* @brief Recebe um byte escrito no PCF8574: P0 RS, P1 RW, P2 E, P3 luz, P4..P7 D4..D7.
+		*
+		* O controlador lê os dados na descida de E.
+		*/
+		void pcf(byte value) {
+			if ((lastPcf & 0x04) && !(value & 0x04) && !(lastPcf & 0x02))
+				nibble(lastPcf, lastPcf & 0x01);
+			lastPcf = value;
+		}
+
+		/**
+		* @brief Lê o _busy flag_.
+		*/
+		bool busy() {
+			if (busyReads == 0)
+				return false;
+			busyReads--;
+			return true;
+		}
+
+		/**
+		* @brief Texto de uma linha da tela, terminado em '\0'.
+		*
+		* @param out   Destino, com pelo menos `cols` + 1 bytes.
+		* @param row   Linha, de 0 a 3 num controlador de duas linhas.
+		* @param cols  Colunas da tela.
+		*/
+		const char *line(char *out, byte row, byte cols) const {
+			byte start = ((row & 1) ? 0x40 : 0) + ((row & 2) ? cols : 0);
+			memcpy(out, ddram + start, cols);
+			out[cols] = '\0';
+			return out;
+		}
+
+	private:
+		int highNibble;   // Primeiro nibble de um byte em 4 bits; -1 se não há
+		byte lastPcf;     // Último byte do PCF8574, para achar a descida de E
+
+		// Avança o contador; com duas linhas a DDRAM são dois trechos de 40
+		void advance() {
+			if (!(entryMode & 0x02))
+				address = (address - 1) & 0x7F;
+			else if (functionSet & 0x08)
+				address = address == 0x27 ? 0x40 : (address == 0x67 ? 0x00 : address + 1);
+			else
+				address = (address + 1) & 0x7F;
+		}
+};
+
+/**
+ * @struct Hd44780ModelBus
+ * @brief Barramento de `Hd44780` ligado a um ou dois `Hd44780Model`.
+ *
+ * Conta as escritas feitas com o controlador ainda ocupado, que no LCD real
+ * seriam perdidas.
+ */
+struct Hd44780ModelBus {
+	enum { DATA_LENGTH = 0x10 };
+
+	Hd44780Model *model[2];
+	byte current;              /**< Controlador escolhido por `select()`. */
+	byte light;                /**< Último `setBacklight()`. */
+	unsigned int busyWrites;   /**< Escritas com o controlador ocupado. */
+	unsigned int flushes;      /**< Chamadas de `flush()`. */
+
+	Hd44780ModelBus(Hd44780Model *first, Hd44780Model *second = NULL)
+		: current(0), light(0), busyWrites(0), flushes(0) {
+		model[0] = first;
+		model[1] = second;
+	}
+	void begin() {}
+	void write(byte value, bool rs) {
+		if (model[current]->busyReads != 0)
+			busyWrites++;
+		model[current]->write(value, rs);
+	}
+	bool busy() { return model[current]->busy(); }
+	void flush() { flushes++; }
+	void setBacklight(byte on) { light = on; }
+	void select(byte controller) { current = controller; }
+};
+
+#endif // HD44780_MODEL_H
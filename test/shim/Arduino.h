@@ -0,0 +1,165 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+/**
+ * @file Arduino.h
+ * @brief Núcleo Arduino mínimo para compilar o firmware no PC (testes e medições).
+ *
+ * Tem só o que o firmware usa. O que no Nano é hardware fica em variáveis que
+ * os testes leem e alteram:
+ * - `millis()` é um relógio simulado (`shimMillis`), avançado por `delay()`
+ *   e pelos testes; `micros()` é o relógio real do PC, usado só em medições;
+ * - `Serial` guarda o que é escrito e entrega o que os testes põem com `feed()`;
+ * - `tone()` anota o último bipe em `shimTone`;
+ * - `attachInterrupt()` guarda a rotina em `shimInterrupt`, para os testes a
+ *   chamarem no lugar do pino;
+ * - `delayMicroseconds()` chama `shimDelayHook`, se houver: os testes olham
+ *   os pinos no meio de um pulso.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH          0x1
+#define LOW           0x0
+#define INPUT         0x0
+#define OUTPUT        0x1
+#define INPUT_PULLUP  0x2
+#define CHANGE        1
+#define FALLING       2
+#define RISING        3
+
+#define digitalPinToInterrupt(p)  ((p) == 2 ? 0 : ((p) == 3 ? 1 : -1))
+
+#define noInterrupts() cli()
+#define interrupts()   sei()
+
+template <typename T> inline T min(T a, T b) { return a < b ? a : b; }
+template <typename T> inline T max(T a, T b) { return a > b ? a : b; }
+template <typename T> inline T constrain(T x, T a, T b) { return x < a ? a : x > b ? b : x; }
+
+extern unsigned long shimMillis;
+extern void (*shimDelayHook)(unsigned int us);
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+void attachInterrupt(uint8_t interrupt, void (*isr)(), int mode);
+
+/**
+ * @brief Último `tone()`/`noTone()`.
+ */
+struct ShimTone {
+	uint8_t pin;
+	unsigned int frequency;      /**< 0 depois de `noTone()`. */
+	unsigned long duration;
+	unsigned long calls;         /**< Chamadas de `tone()` desde o início. */
+};
+extern ShimTone shimTone;
+
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration = 0);
+void noTone(uint8_t pin);
+
+extern void (*shimInterrupt[2])();
+
+char *itoa(int value, char *str, int base);
+char *ltoa(long value, char *str, int base);
+char *utoa(unsigned int value, char *str, int base);
+char *ultoa(unsigned long value, char *str, int base);
+char *dtostrf(double value, signed char width, unsigned char precision, char *str);
+
+/**
+ * @class Print
+ * @brief Saída de caracteres, com os `print()` usados pelo firmware.
+ */
+class Print {
+	public:
+		virtual ~Print() {}
+		virtual size_t write(uint8_t c) = 0;
+		virtual size_t write(const uint8_t *buffer, size_t size);
+		size_t write(const char *str) { return str == NULL ? 0 : write((const uint8_t *) str, strlen(str)); }
+		size_t write(const char *buffer, size_t size) { return write((const uint8_t *) buffer, size); }
+		virtual int availableForWrite() { return 0; }
+		virtual void flush() {}
+
+		size_t print(const __FlashStringHelper *str) { return write((const char *) str); }
+		size_t print(const char *str) { return write(str); }
+		size_t print(char c) { return write((uint8_t) c); }
+		size_t print(int value, int base = 10) { return print((long) value, base); }
+		size_t print(unsigned int value, int base = 10) { return print((unsigned long) value, base); }
+		size_t print(long value, int base = 10);
+		size_t print(unsigned long value, int base = 10);
+		size_t print(double value, int digits = 2);
+		size_t println() { return write("\r\n"); }
+		template <typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+		template <typename T> size_t println(T value, int extra) { size_t n = print(value, extra); return n + println(); }
+};
+
+/**
+ * @class Stream
+ * @brief Canal com leitura, como no núcleo Arduino (sem os tempos de espera).
+ */
+class Stream : public Print {
+	public:
+		virtual int available() = 0;
+		virtual int read() = 0;
+		virtual int peek() = 0;
+};
+
+#define SERIAL_RX_BUFFER_SIZE 64
+#define SERIAL_TX_BUFFER_SIZE 64
+#define SHIM_SERIAL_CAPACITY  4096
+
+/**
+ * @class HardwareSerial
+ * @brief Serial simulada: a linha não tem atraso e o buffer de recepção não tem o limite de 64 bytes.
+ */
+class HardwareSerial : public Stream {
+	public:
+		unsigned long baud;                   /**< Taxa do último `begin()`; 0 antes dele. */
+		unsigned long begins;                 /**< Chamadas de `begin()`. */
+		char output[SHIM_SERIAL_CAPACITY];    /**< O que foi escrito desde o último `clearOutput()`, terminado em '\0'. */
+		size_t outputSize;
+
+		HardwareSerial() : baud(0), begins(0), outputSize(0), inHead(0), inTail(0) { output[0] = '\0'; }
+		void begin(unsigned long rate) { baud = rate; begins++; }
+		void end() {}
+
+		/** @brief Põe bytes na recepção, como se chegassem pela linha. */
+		void feed(const char *data, size_t size);
+		void feed(const char *str) { feed(str, strlen(str)); }
+		/** @brief Descarta o que foi escrito. */
+		void clearOutput() { outputSize = 0; output[0] = '\0'; }
+
+		int available() { return inHead - inTail; }
+		int read() { return inTail == inHead ? -1 : (unsigned char) input[inTail++]; }
+		int peek() { return inTail == inHead ? -1 : (unsigned char) input[inTail]; }
+		size_t write(uint8_t c);
+		using Print::write;
+		int availableForWrite() { return SERIAL_TX_BUFFER_SIZE - 1; }
+		void flush() {}
+		operator bool() { return true; }
+
+	private:
+		char input[SHIM_SERIAL_CAPACITY];
+		size_t inHead;
+		size_t inTail;
+};
+
+extern HardwareSerial Serial;
+
+#endif // ARDUINO_H
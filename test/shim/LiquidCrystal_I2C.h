@@ -0,0 +1,47 @@
+#ifndef LIQUIDCRYSTAL_I2C_H
+#define LIQUIDCRYSTAL_I2C_H
+
+/**
+ * @file LiquidCrystal_I2C.h
+ * @brief LCD simulado com a interface do `LiquidCrystal_I2C`: o texto fica em `screen`, linha a linha.
+ */
+
+#include <Arduino.h>
+
+class LiquidCrystal_I2C : public Print {
+	public:
+		enum { MAX_COLS = 40, MAX_ROWS = 4 };
+
+		char screen[MAX_ROWS][MAX_COLS + 1];   /**< Texto de cada linha, terminado em '\0'. */
+
+		LiquidCrystal_I2C(uint8_t, uint8_t cols, uint8_t rows) : cols(cols), rows(rows) { clear(); }
+		void init() { clear(); }
+		void clear() {
+			memset(screen, 0, sizeof(screen));
+			for (uint8_t r = 0; r < rows; r++)
+				memset(screen[r], ' ', cols);
+			col = row = 0;
+		}
+		void home() { col = row = 0; }
+		void setCursor(uint8_t c, uint8_t r) { col = c; row = r; }
+		size_t write(uint8_t c) {
+			if (row < rows && col < cols)
+				screen[row][col] = c;
+			col++;
+			return 1;
+		}
+		using Print::write;
+		void createChar(uint8_t, const uint8_t *) {}
+		void backlight() {}
+		void noBacklight() {}
+		void setBacklight(uint8_t) {}
+		void setContrast(uint8_t) {}
+		void noAutoscroll() {}
+		void noBlink() {}
+
+	private:
+		uint8_t cols, rows;
+		uint8_t col, row;
+};
+
+#endif // LIQUIDCRYSTAL_I2C_H
@@ -0,0 +1,53 @@
+#include <RTClib.h>
+
+static const uint8_t daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30};
+
+/*****************************************************************************/
+/* Dias desde 01/01/2000, válido de 2000 a 2099, como no RTClib.             */
+/*****************************************************************************/
+static uint16_t date2days(uint16_t y, uint8_t m, uint8_t d) {
+	if (y >= 2000)
+		y -= 2000;
+	uint16_t days = d;
+	for (uint8_t i = 1; i < m; i++)
+		days += daysInMonth[i - 1];
+	if (m > 2 && y % 4 == 0)
+		days++;
+	return days + 365 * y + (y + 3) / 4 - 1;
+}
+
+DateTime::DateTime(uint32_t t) {
+	t -= SECONDS_FROM_1970_TO_2000;
+	ss = t % 60;
+	t /= 60;
+	mm = t % 60;
+	t /= 60;
+	hh = t % 24;
+	uint16_t days = t / 24;
+	uint8_t leap;
+	for (yOff = 0;; yOff++) {
+		leap = yOff % 4 == 0;
+		if (days < 365 + leap)
+			break;
+		days -= 365 + leap;
+	}
+	for (m = 1; m < 12; m++) {
+		uint8_t dim = daysInMonth[m - 1];
+		if (leap && m == 2)
+			dim++;
+		if (days < dim)
+			break;
+		days -= dim;
+	}
+	d = days + 1;
+}
+
+DateTime::DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour, uint8_t min, uint8_t sec)
+	: yOff(year >= 2000 ? year - 2000 : year), m(month), d(day), hh(hour), mm(min), ss(sec)
+{
+}
+
+uint32_t DateTime::unixtime() const {
+	uint32_t days = date2days(yOff, m, d);
+	return ((days * 24 + hh) * 60 + mm) * 60 + ss + SECONDS_FROM_1970_TO_2000;
+}
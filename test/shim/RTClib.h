@@ -0,0 +1,56 @@
+#ifndef RTCLIB_H
+#define RTCLIB_H
+
+/**
+ * @file RTClib.h
+ * @brief `DateTime` e um DS3231 simulado, que anda pelo `millis()` a partir do último `adjust()`.
+ */
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#define SECONDS_FROM_1970_TO_2000 946684800UL
+
+class DateTime {
+	public:
+		DateTime(uint32_t t = SECONDS_FROM_1970_TO_2000);
+		DateTime(uint16_t year, uint8_t month, uint8_t day, uint8_t hour = 0, uint8_t min = 0, uint8_t sec = 0);
+		uint16_t year() const { return 2000 + yOff; }
+		uint8_t month() const { return m; }
+		uint8_t day() const { return d; }
+		uint8_t hour() const { return hh; }
+		uint8_t minute() const { return mm; }
+		uint8_t second() const { return ss; }
+		uint32_t unixtime() const;
+
+	private:
+		uint8_t yOff, m, d, hh, mm, ss;
+};
+
+enum Ds3231SqwPinMode {
+	DS3231_OFF = 0x1C,
+	DS3231_SquareWave1Hz = 0x00,
+	DS3231_SquareWave1kHz = 0x08,
+	DS3231_SquareWave4kHz = 0x10,
+	DS3231_SquareWave8kHz = 0x18
+};
+
+class RTC_DS3231 {
+	public:
+		Ds3231SqwPinMode sqwMode;  /**< Modo do último `writeSqwPinMode()`. */
+		float temperature;         /**< Devolvida por `getTemperature()`. */
+
+		RTC_DS3231() : sqwMode(DS3231_OFF), temperature(25.0), seconds(SECONDS_FROM_1970_TO_2000), setAt(0) {}
+		bool begin(TwoWire * = &Wire) { return true; }
+		bool lostPower() { return false; }
+		void adjust(const DateTime &dt) { seconds = dt.unixtime(); setAt = millis(); }
+		DateTime now() { return DateTime(seconds + (millis() - setAt) / 1000); }
+		void writeSqwPinMode(Ds3231SqwPinMode mode) { sqwMode = mode; }
+		float getTemperature() { return temperature; }
+
+	private:
+		uint32_t seconds;
+		unsigned long setAt;
+};
+
+#endif // RTCLIB_H
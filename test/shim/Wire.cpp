@@ -0,0 +1,42 @@
+#include <Wire.h>
+
+TwoWire Wire;
+
+/*****************************************************************************/
+/* write()                                                                   */
+/* Como no Wire do núcleo, o que passa de BUFFER_LENGTH é descartado.        */
+/*****************************************************************************/
+size_t TwoWire::write(uint8_t value) {
+	if (txSize == BUFFER_LENGTH)
+		return 0;
+	txBuffer[txSize++] = value;
+	return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t size) {
+	size_t n = 0;
+	while (n < size && write(data[n]) == 1)
+		n++;
+	return n;
+}
+
+/*****************************************************************************/
+/* endTransmission()                                                         */
+/*****************************************************************************/
+uint8_t TwoWire::endTransmission(bool) {
+	uint8_t status = onWrite == NULL ? 0 : onWrite(address, txBuffer, txSize);
+	txSize = 0;
+	return status;
+}
+
+/*****************************************************************************/
+/* requestFrom()                                                             */
+/*****************************************************************************/
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t size) {
+	if (size > BUFFER_LENGTH)
+		size = BUFFER_LENGTH;
+	memset(rxBuffer, 0, size);
+	rxSize = onRead == NULL ? size : onRead(address, rxBuffer, size);
+	rxPos = 0;
+	return rxSize;
+}
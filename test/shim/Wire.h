@@ -0,0 +1,49 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+/**
+ * @file Wire.h
+ * @brief Barramento I2C simulado: as transações vão para os dispositivos que os testes ligarem.
+ *
+ * Sem dispositivo ligado, toda escrita é confirmada e toda leitura devolve zeros.
+ */
+
+#include <Arduino.h>
+
+#define BUFFER_LENGTH 32
+
+class TwoWire {
+	public:
+		/**
+		* @brief Recebe uma escrita; devolve o código de `endTransmission()` (0 confirmada).
+		*/
+		uint8_t (*onWrite)(uint8_t address, const uint8_t *data, uint8_t size);
+		/**
+		* @brief Preenche uma leitura; devolve quantos bytes o dispositivo entregou.
+		*/
+		uint8_t (*onRead)(uint8_t address, uint8_t *data, uint8_t size);
+		unsigned long clock;   /**< Frequência do último `setClock()`. */
+
+		TwoWire() : onWrite(NULL), onRead(NULL), clock(100000), address(0), txSize(0), rxSize(0), rxPos(0) {}
+		void begin() { clock = 100000; }
+		void setClock(unsigned long frequency) { clock = frequency; }
+		void beginTransmission(uint8_t address) { this->address = address; txSize = 0; }
+		size_t write(uint8_t value);
+		size_t write(const uint8_t *data, size_t size);
+		uint8_t endTransmission(bool stop = true);
+		uint8_t requestFrom(uint8_t address, uint8_t size);
+		int available() { return rxSize - rxPos; }
+		int read() { return rxPos < rxSize ? rxBuffer[rxPos++] : -1; }
+
+	private:
+		uint8_t address;
+		uint8_t txBuffer[BUFFER_LENGTH];
+		uint8_t txSize;
+		uint8_t rxBuffer[BUFFER_LENGTH];
+		uint8_t rxSize;
+		uint8_t rxPos;
+};
+
+extern TwoWire Wire;
+
+#endif // WIRE_H
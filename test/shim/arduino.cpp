@@ -0,0 +1,181 @@
+#include <Arduino.h>
+#include <stdio.h>
+#include <chrono>
+
+HardwareSerial Serial;
+unsigned long shimMillis = 0;
+long shimTimer1Count = -1;
+void (*shimDelayHook)(unsigned int us);
+ShimTone shimTone;
+void (*shimInterrupt[2])();
+
+volatile uint8_t SREG = 0x80;
+volatile uint8_t PORTB, PORTC, PORTD;
+volatile uint8_t DDRB, DDRC, DDRD;
+volatile uint8_t PINB, PINC, PIND;
+volatile uint8_t UDR0, UCSR0A, UCSR0B, UCSR0C, UBRR0H, UBRR0L;
+volatile uint8_t TCCR1A, TCCR1B, TIFR1, TIMSK1;
+
+// SRAM livre simulada: health.cpp a enxerga como o fim das variáveis globais
+extern "C" char __heap_start[SHIM_FREE_RAM];
+extern "C" char *__brkval;
+char __heap_start[SHIM_FREE_RAM];
+char *__brkval = NULL;
+uintptr_t SP = (uintptr_t) (__heap_start + SHIM_FREE_RAM - 1);
+
+/*****************************************************************************/
+/* Tempo                                                                     */
+/*****************************************************************************/
+static unsigned long long nanos() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+	           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+unsigned long millis() {
+	return shimMillis;
+}
+
+unsigned long micros() {
+	return nanos() / 1000;
+}
+
+void delay(unsigned long ms) {
+	shimMillis += ms;
+}
+
+void delayMicroseconds(unsigned int us) {
+	if (shimDelayHook != NULL)
+		shimDelayHook(us);
+}
+
+/*****************************************************************************/
+/* shimTimer1()                                                              */
+/* Contagens a 16 MHz divididos pelo prescaler de TCCR1B; parado sem ele.    */
+/* Com shimTimer1Count, o valor posto pelo teste.                            */
+/*****************************************************************************/
+uint16_t shimTimer1() {
+	static const unsigned int prescalers[] = {0, 1, 8, 64, 256, 1024, 0, 0};
+	if (shimTimer1Count >= 0)
+		return shimTimer1Count;
+	unsigned int prescaler = prescalers[TCCR1B & 0x07];
+	if (prescaler == 0)
+		return 0;
+	return nanos() * (F_CPU / 1000000UL) / 1000 / prescaler;
+}
+
+/*****************************************************************************/
+/* Pinos                                                                     */
+/*****************************************************************************/
+void pinMode(uint8_t, uint8_t) {
+}
+
+void digitalWrite(uint8_t, uint8_t) {
+}
+
+int digitalRead(uint8_t) {
+	return LOW;
+}
+
+void attachInterrupt(uint8_t interrupt, void (*isr)(), int) {
+	if (interrupt < 2)
+		shimInterrupt[interrupt] = isr;
+}
+
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration) {
+	shimTone.pin = pin;
+	shimTone.frequency = frequency;
+	shimTone.duration = duration;
+	shimTone.calls++;
+}
+
+void noTone(uint8_t pin) {
+	shimTone.pin = pin;
+	shimTone.frequency = 0;
+}
+
+/*****************************************************************************/
+/* Conversões da avr-libc                                                    */
+/*****************************************************************************/
+char *ultoa(unsigned long value, char *str, int base) {
+	char digits[33];
+	int n = 0;
+	do {
+		int d = value % base;
+		digits[n++] = d < 10 ? '0' + d : 'a' + d - 10;
+		value /= base;
+	} while (value != 0);
+	for (int i = 0; i < n; i++)
+		str[i] = digits[n - 1 - i];
+	str[n] = '\0';
+	return str;
+}
+
+char *ltoa(long value, char *str, int base) {
+	if (value < 0 && base == 10) {
+		str[0] = '-';
+		ultoa(-(unsigned long) value, str + 1, base);
+		return str;
+	}
+	return ultoa((unsigned long) value, str, base);
+}
+
+char *utoa(unsigned int value, char *str, int base) {
+	return ultoa(value, str, base);
+}
+
+char *itoa(int value, char *str, int base) {
+	if (value < 0 && base == 10)
+		return ltoa(value, str, base);
+	return ultoa((unsigned int) value, str, base);
+}
+
+char *dtostrf(double value, signed char width, unsigned char precision, char *str) {
+	sprintf(str, "%*.*f", width, precision, value);
+	return str;
+}
+
+/*****************************************************************************/
+/* Print                                                                     */
+/*****************************************************************************/
+size_t Print::write(const uint8_t *buffer, size_t size) {
+	size_t n = 0;
+	while (size-- > 0)
+		n += write(*buffer++);
+	return n;
+}
+
+size_t Print::print(long value, int base) {
+	char str[34];
+	return write(ltoa(value, str, base));
+}
+
+size_t Print::print(unsigned long value, int base) {
+	char str[33];
+	return write(ultoa(value, str, base));
+}
+
+size_t Print::print(double value, int digits) {
+	char str[48];
+	snprintf(str, sizeof(str), "%.*f", digits, value);
+	return write(str);
+}
+
+/*****************************************************************************/
+/* HardwareSerial                                                            */
+/*****************************************************************************/
+void HardwareSerial::feed(const char *data, size_t size) {
+	if (inTail == inHead)
+		inTail = inHead = 0;
+	if (size > SHIM_SERIAL_CAPACITY - inHead)
+		size = SHIM_SERIAL_CAPACITY - inHead;
+	memcpy(input + inHead, data, size);
+	inHead += size;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+	if (outputSize == SHIM_SERIAL_CAPACITY - 1)
+		return 0;
+	output[outputSize++] = c;
+	output[outputSize] = '\0';
+	return 1;
+}
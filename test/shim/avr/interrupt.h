@@ -0,0 +1,16 @@
+#ifndef INTERRUPT_H
+#define INTERRUPT_H
+
+/**
+ * @file interrupt.h
+ * @brief Interrupções no PC: não há nenhuma assíncrona, então `cli()`/`sei()` só mexem no bit I de `SREG`.
+ */
+
+#include <avr/io.h>
+
+#define cli() (SREG &= 0x7F)
+#define sei() (SREG |= 0x80)
+
+#define ISR(vector) extern "C" void vector()
+
+#endif // INTERRUPT_H
@@ -0,0 +1,71 @@
+#ifndef IO_H
+#define IO_H
+
+/**
+ * @file io.h
+ * @brief Registradores do ATmega328P usados pelo firmware, como variáveis.
+ *
+ * O Timer1 conta pelo relógio do PC: `TCNT1` avança como avançaria a
+ * 16 MHz com o _prescaler_ escolhido em `TCCR1B`; com `shimTimer1Count`
+ * maior ou igual a 0, vale o que o teste puser ali. `SP` aponta para dentro de
+ * `__heap_start`, a SRAM livre simulada (ver health.cpp).
+ */
+
+#include <stdint.h>
+
+extern volatile uint8_t SREG;
+extern volatile uint8_t PORTB, PORTC, PORTD;
+extern volatile uint8_t DDRB, DDRC, DDRD;
+extern volatile uint8_t PINB, PINC, PIND;
+extern volatile uint8_t UDR0, UCSR0A, UCSR0B, UCSR0C, UBRR0H, UBRR0L;
+extern volatile uint8_t TCCR1A, TCCR1B, TIFR1, TIMSK1;
+extern uintptr_t SP;
+
+extern long shimTimer1Count;
+uint16_t shimTimer1();
+#define TCNT1 (shimTimer1())
+
+#define SHIM_FREE_RAM 1024  /**< Bytes da SRAM livre simulada. */
+
+#define _BV(bit) (1 << (bit))
+
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PC0 0
+#define PC1 1
+#define PC2 2
+#define PC3 3
+#define PD0 0
+#define PD1 1
+#define PD2 2
+#define PD3 3
+#define PD4 4
+#define PD5 5
+#define PD6 6
+#define PD7 7
+
+#define RXC0   7
+#define TXC0   6
+#define UDRE0  5
+#define FE0    4
+#define DOR0   3
+#define UPE0   2
+#define U2X0   1
+#define RXCIE0 7
+#define TXCIE0 6
+#define UDRIE0 5
+#define RXEN0  4
+#define TXEN0  3
+#define UCSZ01 2
+#define UCSZ00 1
+
+#define CS10   0
+#define CS11   1
+#define CS12   2
+#define TOV1   0
+
+#endif // IO_H
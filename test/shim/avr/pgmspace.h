@@ -0,0 +1,30 @@
+#ifndef PGMSPACE_H
+#define PGMSPACE_H
+
+/**
+ * @file pgmspace.h
+ * @brief Memória de programa no PC: uma só memória, então `PROGMEM` some e as leituras são diretas.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P          const char *
+#define PSTR(s)        (s)
+
+#define pgm_read_byte(addr)   (*(const uint8_t *) (addr))
+#define pgm_read_word(addr)   (*(const uint16_t *) (addr))
+#define pgm_read_dword(addr)  (*(const uint32_t *) (addr))
+#define pgm_read_ptr(addr)    (*(void * const *) (addr))
+
+#define memcpy_P   memcpy
+#define strcpy_P   strcpy
+#define strncpy_P  strncpy
+#define strlen_P   strlen
+#define strcmp_P   strcmp
+
+class __FlashStringHelper;
+#define F(s) ((const __FlashStringHelper *) (s))
+
+#endif // PGMSPACE_H
@@ -0,0 +1,16 @@
+#ifndef SLEEP_H
+#define SLEEP_H
+
+/**
+ * @file sleep.h
+ * @brief Sono do processador; no PC volta na hora, como se uma interrupção já tivesse chegado.
+ */
+
+#define SLEEP_MODE_IDLE 0
+
+#define set_sleep_mode(mode) ((void) (mode))
+#define sleep_enable()
+#define sleep_cpu()
+#define sleep_disable()
+
+#endif // SLEEP_H
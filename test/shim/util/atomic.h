@@ -0,0 +1,20 @@
+#ifndef ATOMIC_H
+#define ATOMIC_H
+
+/**
+ * @file atomic.h
+ * @brief `ATOMIC_BLOCK` da avr-libc: desliga as interrupções no bloco e restaura `SREG` na saída.
+ */
+
+#include <avr/interrupt.h>
+
+#define ATOMIC_RESTORESTATE  uint8_t shimSreg __attribute__((cleanup(shimRestore))) = SREG
+#define ATOMIC_FORCEON       uint8_t shimSreg __attribute__((cleanup(shimForceOn))) = 0
+
+static inline void shimRestore(const uint8_t *sreg) { SREG = *sreg; }
+static inline void shimForceOn(const uint8_t *) { sei(); }
+static inline uint8_t shimCli() { cli(); return 1; }
+
+#define ATOMIC_BLOCK(type) for (type, shimDone = shimCli(); shimDone; shimDone = 0)
+
+#endif // ATOMIC_H
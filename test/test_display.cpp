@@ -0,0 +1,122 @@
+#include <Arduino.h>
+#include "display.h"
+#include "check.h"
+
+typedef DisplayLine<8, 20> Line;
+
+/*****************************************************************************/
+/* Linha com o texto dado, no início da rolagem.                             */
+/*****************************************************************************/
+static void setText(Line &d, const char *text, byte mode) {
+	memset(&d, 0, sizeof(d));
+	strcpy(d.message, text);
+	d.messageSize = strlen(text);
+	d.scrollMode = mode;
+	d.stepDelay = 100;
+	d.pauseStart = 1000;
+	d.pauseEnd = 2000;
+	d.restart();
+}
+
+/*****************************************************************************/
+/* Trecho visível, terminado em '\0'.                                        */
+/*****************************************************************************/
+static const char *visible(const Line &d) {
+	static char out[9];
+	d.render(out);
+	out[8] = '\0';
+	return out;
+}
+
+static void testCopiaN() {
+	char dest[5];
+	dest[4] = '\0';
+	copiaN<4>(dest, "ab", 2, 3);
+	CHECK_STR(dest, "ab  ");
+	copiaN<4>(dest, "abcdef", 6, 1);
+	CHECK_STR(dest, "bcde");
+	copiaN<4>(dest, "abcdef", 6, 9);
+	CHECK_STR(dest, "cdef");
+}
+
+/*****************************************************************************/
+/* Texto que cabe não rola e é completado com espaços.                       */
+/*****************************************************************************/
+static void testShortText() {
+	Line d;
+	setText(d, "Oi", SCROLL_ROLL);
+	CHECK(!d.scrolls());
+	CHECK_STR(visible(d), "Oi      ");
+}
+
+/*****************************************************************************/
+/* SCROLL_ROLL: avança até o fim, pausa e volta de uma vez ao início.        */
+/*****************************************************************************/
+static void testRoll() {
+	Line d;
+	setText(d, "ABCDEFGHIJ", SCROLL_ROLL);
+	CHECK(d.scrolls());
+	CHECK_STR(visible(d), "ABCDEFGH");
+	CHECK(d.advance() == 100);
+	CHECK_STR(visible(d), "BCDEFGHI");
+	CHECK(d.advance() == 2000);
+	CHECK_STR(visible(d), "CDEFGHIJ");
+	CHECK(d.advance() == 1000);
+	CHECK_STR(visible(d), "ABCDEFGH");
+}
+
+/*****************************************************************************/
+/* SCROLL_BOUNCE: volta passo a passo, com as pausas nas duas pontas.        */
+/*****************************************************************************/
+static void testBounce() {
+	Line d;
+	setText(d, "ABCDEFGHIJ", SCROLL_BOUNCE);
+	CHECK(d.advance() == 100);
+	CHECK(d.advance() == 2000);
+	CHECK_STR(visible(d), "CDEFGHIJ");
+	CHECK(d.advance() == 100);
+	CHECK_STR(visible(d), "BCDEFGHI");
+	CHECK(d.advance() == 1000);
+	CHECK_STR(visible(d), "ABCDEFGH");
+	CHECK(d.advance() == 100);
+	CHECK_STR(visible(d), "BCDEFGHI");
+}
+
+/*****************************************************************************/
+/* SCROLL_MARQUEE: o texto recomeça depois do separador, sem salto.          */
+/*****************************************************************************/
+static void testMarquee() {
+	Line d;
+	setText(d, "ABCDEFGHIJ", SCROLL_MARQUEE);
+	byte period = 10 + sizeof(MARQUEE_SEPARATOR) - 1;
+	for (byte i = 1; i < period; i++)
+		CHECK(d.advance() == 100);
+	CHECK_STR(visible(d), " ABCDEFG");
+	CHECK(d.advance() == 1000);
+	CHECK_STR(visible(d), "ABCDEFGH");
+	d.startPosition = 6;
+	CHECK_STR(visible(d), "GHIJ * A");
+}
+
+/*****************************************************************************/
+/* SCROLL_EASE: passos mais lentos perto das pontas.                         */
+/*****************************************************************************/
+static void testEase() {
+	Line d;
+	setText(d, "ABCDEFGHIJKLMNOPQRST", SCROLL_ROLL | SCROLL_EASE);
+	CHECK(d.advance() == 150);
+	CHECK(d.advance() == 125);
+	CHECK(d.advance() == 112);
+	d.startPosition = 5;
+	CHECK(d.advance() == 101);
+}
+
+int main() {
+	testCopiaN();
+	testShortText();
+	testRoll();
+	testBounce();
+	testMarquee();
+	testEase();
+	return CHECK_RESULT();
+}
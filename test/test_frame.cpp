@@ -0,0 +1,283 @@
+#include <Arduino.h>
+#include "frame.h"
+#include "check.h"
+
+/*****************************************************************************/
+/* Descarta o quadro atual e devolve o próximo, da fila ou da linha, ou ""   */
+/* se não houver.                                                            */
+/*****************************************************************************/
+static const char *receive(SerialProtocol &proto) {
+	if (!proto.nextFrame())
+		proto.receiveFrame();
+	return proto.machState == SerialProtocol::RECEIVED ? proto.receivedChars : "";
+}
+
+static void testPlainFrame() {
+	HardwareSerial line;
+	SerialProtocol proto(line);
+	line.feed("<100|0|0>");
+	CHECK_STR(receive(proto), "100|0|0");
+	CHECK(proto.receivedSize == 7);
+	CHECK(proto.counters.framesReceived == 1);
+	CHECK(!proto.nextFrame());
+	CHECK(proto.machState == SerialProtocol::START);
+}
+
+/*****************************************************************************/
+/* Bytes fora de quadro são descartados e contados.                          */
+/*****************************************************************************/
+static void testGarbageBetweenFrames() {
+	HardwareSerial line;
+	SerialProtocol proto(line);
+	line.feed("xy<1|a|0>\r\n<2|b|0>>");
+	CHECK_STR(receive(proto), "1|a|0");
+	CHECK_STR(receive(proto), "2|b|0");
+	CHECK_STR(receive(proto), "");
+	CHECK(proto.counters.discardedBytes == 5);
+}
+
+/*****************************************************************************/
+/* Um quadro chega em pedaços, em várias chamadas.                           */
+/*****************************************************************************/
+static void testSplitFrame() {
+	HardwareSerial line;
+	SerialProtocol proto(line);
+	line.feed("<500|Fula");
+	CHECK_STR(receive(proto), "");
+	line.feed("no|5000>");
+	CHECK_STR(receive(proto), "500|Fulano|5000");
+}
+
+/*****************************************************************************/
+/* '\<', '\>' e '\\' viram o caractere; '\' antes de outro é erro e some.    */
+/*****************************************************************************/
+static void testEscapes() {
+	HardwareSerial line;
+	SerialProtocol proto(line);
+	line.feed("<500|\\<\\>\\\\|0><5|\\a|0>");
+	CHECK_STR(receive(proto), "500|<>\\|0");
+	CHECK_STR(receive(proto), "5||0");
+	CHECK(proto.counters.escapeErrors == 1);
+}
+
+/*****************************************************************************/
+/* Um '<' no meio de um quadro recomeça a montagem.                          */
+/*****************************************************************************/
+static void testRestart() {
+	HardwareSerial line;
+	SerialProtocol proto(line);
+	line.feed("<500|incomplet<500|x|0>");
+	CHECK_STR(receive(proto), "500|x|0");
+	CHECK_STR(receive(proto), "");
+}
+
+/*****************************************************************************/
+/* Cabem MAX_PROTOCOL_MESSAGE bytes; um a mais descarta o quadro até o '>'.  */
+/*****************************************************************************/
+static void testOversize() {
+	HardwareSerial line;
+	SerialProtocol proto(line);
+	char frame[MAX_PROTOCOL_MESSAGE + 4];
+	frame[0] = '<';
+	memset(frame + 1, 'a', MAX_PROTOCOL_MESSAGE);
+	strcpy(frame + 1 + MAX_PROTOCOL_MESSAGE, ">");
+	line.feed(frame);
+	CHECK(strlen(receive(proto)) == MAX_PROTOCOL_MESSAGE);
+	CHECK(proto.counters.oversizeFrames == 0);
+
+	frame[MAX_PROTOCOL_MESSAGE + 1] = 'a';
+	strcpy(frame + MAX_PROTOCOL_MESSAGE + 2, ">");
+	line.feed(frame);
+	line.feed("\\><1|ok|0>");
+	CHECK_STR(receive(proto), "1|ok|0");
+	CHECK_STR(receive(proto), "");
+	CHECK(proto.counters.oversizeFrames == 1);
+	CHECK(proto.counters.framesReceived == 2);
+}
+
+/*****************************************************************************/
+/* Com a fila cheia a recepção para e o resto espera na linha.               */
+/*****************************************************************************/
+static void testQueue() {
+	HardwareSerial line;
+	SerialProtocol proto(line);
+	line.feed("<1||0><2||0><3||0><4||0><5||0>");
+	CHECK_STR(receive(proto), "1||0");
+	CHECK(line.available() > 0);
+	int frames = 1;
+	while (receive(proto)[0] != '\0')
+		frames++;
+	CHECK(frames == 5);
+	CHECK_STR(proto.receivedChars, "5||0");
+	CHECK(proto.droppedFrames == 0);
+}
+
+/*****************************************************************************/
+/* Pela decodeByte(), como na interrupção de RX, a fila cheia perde quadros. */
+/*****************************************************************************/
+static void testDroppedFrames() {
+	HardwareSerial line;
+	SerialProtocol proto(line);
+	const char *input = "<1||0><2||0><3||0><4||0><5||0>";
+	for (const char *p = input; *p != '\0'; p++)
+		proto.decodeByte(*p);
+	SerialProtocol::Counters c;
+	proto.snapshot(c);
+	CHECK(c.framesReceived == 5);
+	CHECK(c.droppedFrames == 5 - (FRAME_QUEUE_SIZE - 1));
+	CHECK(proto.frames.count() == FRAME_QUEUE_SIZE - 1);
+}
+
+/*****************************************************************************/
+/* sendFrame() escapa e trunca sem separar um '\' do seu caractere.          */
+/*****************************************************************************/
+static void testSendFrame() {
+	HardwareSerial line;
+	SerialProtocol proto(line);
+	CHECK(proto.sendFrame("002|OK|") == 9);
+	CHECK_STR(line.output, "<002|OK|>");
+	line.clearOutput();
+	proto.sendFrame("a<b>c\\d");
+	CHECK_STR(line.output, "<a\\<b\\>c\\\\d>");
+
+	char message[80];
+	memset(message, 'a', sizeof(message) - 1);
+	message[sizeof(message) - 1] = '\0';
+	line.clearOutput();
+	CHECK(proto.sendFrame(message) == MAX_PROTOCOL_MESSAGE);
+	CHECK(line.outputSize == MAX_PROTOCOL_MESSAGE);
+	CHECK(line.output[MAX_PROTOCOL_MESSAGE - 1] == '>');
+
+	message[MAX_PROTOCOL_MESSAGE - 3] = '<';
+	line.clearOutput();
+	proto.sendFrame(message);
+	CHECK(line.output[line.outputSize - 2] == 'a');
+	CHECK(proto.counters.framesSent == 4);
+}
+
+/*****************************************************************************/
+/* O que sendFrame() envia com CRC, verifyTrailer() aceita.                  */
+/*****************************************************************************/
+static void testChecksumRoundTrip() {
+	HardwareSerial line;
+	SerialProtocol proto(line);
+	proto.checksumMode = true;
+	proto.txSeq = 7;
+	proto.sendFrame("500|a<b|0");
+	line.feed(line.output);
+	CHECK(receive(proto)[0] != '\0');
+	CHECK(proto.verifyTrailer());
+	CHECK_STR(proto.receivedChars, "500|a<b|0");
+	CHECK(proto.rxSeq == 7);
+
+	line.clearOutput();
+	proto.sendFrame("500|a<b|0");
+	line.output[2] = '1';  // 510 em vez de 500
+	line.feed(line.output);
+	CHECK(receive(proto)[0] != '\0');
+	CHECK(!proto.verifyTrailer());
+}
+
+/*****************************************************************************/
+/* Põe em receivedChars "content|SEQ|CRC", com o CRC de "content|SEQ"; o CRC */
+/* pode ser trocado por outro texto.                                         */
+/*****************************************************************************/
+static bool trailer(SerialProtocol &proto, const char *content, const char *seq, const char *crcText = NULL) {
+	char crc[6];
+	strcpy(proto.receivedChars, content);
+	strcat(proto.receivedChars, "|");
+	strcat(proto.receivedChars, seq);
+	sprintf(crc, "%04X", crc16((const uint8_t *) proto.receivedChars, strlen(proto.receivedChars)));
+	strcat(proto.receivedChars, "|");
+	strcat(proto.receivedChars, crcText != NULL ? crcText : crc);
+	return proto.verifyTrailer();
+}
+
+/*****************************************************************************/
+/* CRC com exatamente 4 dígitos hexadecimais e SEQ de 1 a 3 dígitos, até     */
+/* 255; o resto é recusado mesmo com o CRC certo.                            */
+/*****************************************************************************/
+static void testTrailerFormat() {
+	HardwareSerial line;
+	SerialProtocol proto(line);
+	CHECK(trailer(proto, "500|a|0", "255"));
+	CHECK(proto.rxSeq == 255);
+	CHECK(trailer(proto, "500|a|0", "0"));
+	CHECK(!trailer(proto, "500|a|0", "256"));
+	CHECK(!trailer(proto, "500|a|0", "0007"));
+	CHECK(!trailer(proto, "500|a|0", ""));
+	CHECK(!trailer(proto, "500|a|0", "1a"));
+	CHECK(!trailer(proto, "500|a|0", "-1"));
+	CHECK(!trailer(proto, "500|a|0", " 7"));
+
+	char crc[8];
+	strcpy(proto.receivedChars, "500|a|0|7");
+	sprintf(crc, "%04X", crc16((const uint8_t *) proto.receivedChars, strlen(proto.receivedChars)));
+	CHECK(trailer(proto, "500|a|0", "7", crc));
+	for (char *p = crc; *p != '\0'; p++)
+		*p |= 0x20;  // Minúsculas; os dígitos não mudam
+	CHECK(trailer(proto, "500|a|0", "7", crc));
+	CHECK(!trailer(proto, "500|a|0", "7", crc + 1));       // 3 dígitos
+	memmove(crc + 1, crc, 5);
+	crc[0] = '0';
+	CHECK(!trailer(proto, "500|a|0", "7", crc));           // 5 dígitos
+	crc[1] = '+';
+	CHECK(!trailer(proto, "500|a|0", "7", crc + 1));
+	CHECK(!trailer(proto, "500|a|0", "7", ""));
+}
+
+/*****************************************************************************/
+/* O trailer cabe no buffer junto com a maior mensagem.                      */
+/*****************************************************************************/
+static void testTrailerFits() {
+	HardwareSerial line;
+	SerialProtocol proto(line);
+	char content[MAX_STRING + 5];
+	strcpy(content, "5|");
+	memset(content + 2, 'a', MAX_STRING);
+	strcpy(content + 2 + MAX_STRING, "|0");
+	proto.checksumMode = true;
+	proto.txSeq = 255;
+	proto.sendFrame(content);
+	line.feed(line.output);
+	CHECK(strlen(receive(proto)) == strlen(content) + CHECKSUM_TRAILER_SIZE);
+	CHECK(proto.verifyTrailer());
+	CHECK_STR(proto.receivedChars, content);
+}
+
+/*****************************************************************************/
+/* O que sendBinary() envia, parseBinary() decodifica.                       */
+/*****************************************************************************/
+static void testBinaryRoundTrip() {
+	HardwareSerial line;
+	SerialProtocol proto(line);
+	proto.binaryMode = true;
+	proto.sendBinary(500, 70000, "Fulano <de> Tal");
+	line.feed(line.output);
+	CHECK(receive(proto)[0] != '\0');
+	int code, ttl;
+	char *message;
+	byte size;
+	CHECK(proto.parseBinary(code, ttl, message, size));
+	CHECK(code == 500);
+	CHECK(ttl == 32767);
+	CHECK(size == 15);
+	CHECK_STR(message, "Fulano <de> Tal");
+}
+
+int main() {
+	testPlainFrame();
+	testGarbageBetweenFrames();
+	testSplitFrame();
+	testEscapes();
+	testRestart();
+	testOversize();
+	testQueue();
+	testDroppedFrames();
+	testSendFrame();
+	testChecksumRoundTrip();
+	testTrailerFormat();
+	testTrailerFits();
+	testBinaryRoundTrip();
+	return CHECK_RESULT();
+}
@@ -0,0 +1,168 @@
+#include <Arduino.h>
+#include "hd44780.h"
+#include "glyphs.h"
+#include "hd44780_model.h"
+#include "check.h"
+
+typedef LcdFrameBuffer<20, 4> Screen;
+typedef Hd44780<Hd44780ModelBus> Lcd;
+
+enum { BUDGET = 8 };  // LCD_FLUSH_BUDGET do sketch
+
+/*****************************************************************************/
+/* Uma passada de enviaLcd(): a carga da CGRAM sai do mesmo orçamento.       */
+/*****************************************************************************/
+static byte pass(Lcd &lcd, Screen &screen, GlyphCache &glyphs) {
+	byte used = glyphs.update(lcd, screen);
+	if (used < BUDGET)
+		used += screen.flush(lcd, BUDGET - used, glyphs);
+	return used;
+}
+
+/*****************************************************************************/
+/* Linha com o texto dado, completada com espaços.                           */
+/*****************************************************************************/
+static void show(Screen &screen, byte row, const char *text) {
+	char line[20];
+	memset(line, ' ', sizeof(line));
+	memcpy(line, text, strlen(text));
+	screen.setLine(row, line);
+}
+
+/*****************************************************************************/
+/* Cada letra vai para uma posição livre, no máximo uma carga por passada, e */
+/* a tela só é enviada depois das cargas, já com as posições da CGRAM.       */
+/*****************************************************************************/
+static void testSlotAssignment() {
+	static const byte eAcute[8] = {0x02, 0x04, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00};
+	Hd44780Model m;
+	Lcd lcd(20, 4, Hd44780ModelBus(&m));
+	Screen screen;
+	GlyphCache glyphs;
+	lcd.init();
+	show(screen, 0, "A\xE7\xE3o \xE9 \xE9");  // Ação é é
+
+	CHECK(pass(lcd, screen, glyphs) == GlyphCache::UPLOAD_COST);
+	CHECK(glyphs.uploads == 1);
+	CHECK(glyphs.slots[0] == 0xE9);          // A mais frequente primeiro
+	CHECK(m.ddram[0] == ' ');                // Nada enviado nesta passada
+	CHECK(pass(lcd, screen, glyphs) == GlyphCache::UPLOAD_COST);
+	CHECK(pass(lcd, screen, glyphs) == GlyphCache::UPLOAD_COST);
+	CHECK(glyphs.uploads == 3);
+	while (screen.pending())
+		CHECK(pass(lcd, screen, glyphs) <= BUDGET + 1);
+	CHECK(glyphs.uploads == 3);
+	CHECK(glyphs.slots[1] == 0xE3);          // Empate: na ordem dos desenhos
+	CHECK(glyphs.slots[2] == 0xE7);
+	CHECK(glyphs.slots[3] == 0);
+	CHECK(memcmp(m.cgram, eAcute, 8) == 0);
+
+	CHECK(glyphs.map('\xE3') == 1 && glyphs.map('\xE7') == 2);
+	CHECK(m.ddram[0] == 'A' && m.ddram[1] == 2 && m.ddram[2] == 1 && m.ddram[3] == 'o');
+	CHECK(m.ddram[5] == 0 && m.ddram[7] == 0);
+	CHECK(lcd.bus.busyWrites == 0);
+}
+
+/*****************************************************************************/
+/* Com as 8 posições ocupadas, sai a letra que está há mais tempo fora da    */
+/* tela, e as visíveis não são recarregadas.                                 */
+/*****************************************************************************/
+static void testLeastRecentlyUsed() {
+	Hd44780Model m;
+	Lcd lcd(20, 4, Hd44780ModelBus(&m));
+	Screen screen;
+	GlyphCache glyphs;
+	lcd.init();
+	show(screen, 0, "\xE0\xE1\xE2\xE3\xE7\xE9\xEA\xED");  // à á â ã ç é ê í
+	while (screen.pending())
+		pass(lcd, screen, glyphs);
+	CHECK(glyphs.uploads == 8);
+	int8_t old = glyphs.map('\xE0');
+
+	show(screen, 0, "\xE1\xE2\xE3\xE7\xE9\xEA\xED");      // Sai à
+	while (screen.pending())
+		pass(lcd, screen, glyphs);
+	show(screen, 0, "\xE1\xE2\xE3\xE7\xE9\xEA\xED\xF3");  // Entra ó
+	while (screen.pending())
+		pass(lcd, screen, glyphs);
+	CHECK(glyphs.uploads == 9);
+	CHECK(glyphs.map('\xF3') == old);
+	CHECK(glyphs.map('\xE0') == 'a');      // Sem posição, vai sem acento
+	CHECK(m.ddram[7] == old);
+}
+
+/*****************************************************************************/
+/* A idade não dá a volta: uma letra fora da tela por 256 chamadas de        */
+/* update() continua sendo a mais antiga.                                    */
+/*****************************************************************************/
+static void testAgeSaturates() {
+	Hd44780Model m;
+	Lcd lcd(20, 4, Hd44780ModelBus(&m));
+	Screen screen;
+	GlyphCache glyphs;
+	lcd.init();
+	show(screen, 0, "\xE0\xE0\xE1\xE1\xE2\xE2\xE3\xE3\xE7\xE7\xE9\xE9\xEA\xEA\xED");
+	while (screen.pending())
+		pass(lcd, screen, glyphs);
+	CHECK(glyphs.uploads == 8);
+	int8_t hidden = glyphs.map('\xED');      // A menos frequente, carregada por último
+	CHECK(hidden == 7);
+
+	for (int i = 0; i < 255; i++) {           // Mais a chamada que traz ú: 256
+		show(screen, 0, "\xE0\xE1\xE2\xE3\xE7\xE9\xEA");
+		screen.edit(1)[0] = '0' + i % 2;    // Toda passada altera a tela
+		screen.touch(1);
+		while (screen.pending())
+			pass(lcd, screen, glyphs);
+	}
+	show(screen, 0, "\xE0\xE1\xE2\xE3\xE7\xE9\xEA\xFA");  // Entra ú
+	while (screen.pending())
+		pass(lcd, screen, glyphs);
+	CHECK(glyphs.uploads == 9);
+	CHECK(glyphs.map('\xFA') == hidden);
+	CHECK(glyphs.map('\xE0') == 0);
+}
+
+/*****************************************************************************/
+/* '\0' é um caractere como outro: a carga numa posição livre não reescreve  */
+/* as posições com '\0', e uma posição invalidada é reescrita mesmo se o     */
+/* texto novo for '\0'.                                                      */
+/*****************************************************************************/
+static void testNulCharacter() {
+	Hd44780Model m;
+	Lcd lcd(20, 4, Hd44780ModelBus(&m));
+	Screen screen;
+	GlyphCache glyphs;
+	lcd.init();
+	char line[20];
+	memset(line, ' ', sizeof(line));
+	line[5] = '\0';
+	screen.setLine(0, line);
+	while (screen.pending())
+		pass(lcd, screen, glyphs);
+
+	screen.edit(0)[10] = '\xE9';
+	screen.touch(0);
+	CHECK(pass(lcd, screen, glyphs) == GlyphCache::UPLOAD_COST);
+	CHECK(pass(lcd, screen, glyphs) == 2);   // setCursor() e a letra, só
+	CHECK(!screen.pending());
+
+	screen.edit(0)[3] = 'x';
+	screen.touch(0);
+	while (screen.pending())
+		pass(lcd, screen, glyphs);
+	screen.invalidate('x');
+	screen.edit(0)[3] = '\0';
+	screen.touch(0);
+	while (screen.pending())
+		pass(lcd, screen, glyphs);
+	CHECK(m.ddram[3] == 0);
+}
+
+int main() {
+	testSlotAssignment();
+	testLeastRecentlyUsed();
+	testAgeSaturates();
+	testNulCharacter();
+	return CHECK_RESULT();
+}
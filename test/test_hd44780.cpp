@@ -0,0 +1,233 @@
+#include <Arduino.h>
+#include <Wire.h>
+#include "hd44780.h"
+#include "lcdbuffer.h"
+#include "hd44780_model.h"
+#include "check.h"
+
+// Pinos de hd44780.cpp
+#define LCD_RW  _BV(PB1)
+#define LCD_HI  0xF0
+#define LCD_LO  0x0F
+
+static unsigned long readPulses;
+static unsigned long contention;
+
+/*****************************************************************************/
+/* Nos pulsos com RW alto quem dirige D0..D7 é o LCD: nenhuma dessas linhas  */
+/* pode estar como saída no Arduino.                                         */
+/*****************************************************************************/
+static void watchBus(unsigned int) {
+	if (!(PORTB & LCD_RW))
+		return;
+	readPulses++;
+	if ((DDRD & LCD_HI) || (DDRC & LCD_LO))
+		contention++;
+}
+
+static void useLcd(Print &lcd) {
+	lcd.print("Sala 1");
+}
+
+static void testBus8Contention() {
+	Hd44780<Hd44780Bus8> lcd(20, 4);
+	readPulses = 0;
+	contention = 0;
+	lcd.init();
+	lcd.setCursor(0, 1);
+	useLcd(lcd);
+	CHECK(readPulses > 0);
+	CHECK(contention == 0);
+	CHECK((DDRC & LCD_LO) == LCD_LO);
+	CHECK((DDRD & LCD_HI) == LCD_HI);
+}
+
+/*****************************************************************************/
+/* No barramento de 4 bits D0..D3 não estão ligados: PORTC fica como está.   */
+/*****************************************************************************/
+static void testBus4Contention() {
+	Hd44780<Hd44780Bus4> lcd(20, 4);
+	DDRC = 0x30;
+	readPulses = 0;
+	contention = 0;
+	lcd.init();
+	lcd.setCursor(0, 1);
+	useLcd(lcd);
+	CHECK(readPulses > 0);
+	CHECK(contention == 0);
+	CHECK(DDRC == 0x30);
+	CHECK((DDRD & LCD_HI) == LCD_HI);
+}
+
+/*****************************************************************************/
+/* Instruções recebidas pelo modelo, na ordem.                               */
+/*****************************************************************************/
+static bool logIs(const Hd44780Model &m, const byte *expected, byte size) {
+	return m.logSize == size && memcmp(m.log, expected, size) == 0;
+}
+
+static bool startsWith(const char *line, const char *text) {
+	return strncmp(line, text, strlen(text)) == 0;
+}
+
+/*****************************************************************************/
+/* init(): function set de 8 bits e duas linhas, tela ligada sem cursor,     */
+/* clear e entry mode, sem escrever com o controlador ocupado.               */
+/*****************************************************************************/
+static void testInitSequence() {
+	static const byte expected[] = {0x38, 0x0C, 0x01, 0x06};
+	Hd44780Model m;
+	Hd44780<Hd44780ModelBus> lcd(20, 4, Hd44780ModelBus(&m));
+	lcd.init();
+	CHECK(logIs(m, expected, sizeof(expected)));
+	CHECK(!m.fourBit);
+	CHECK(lcd.bus.busyWrites == 0);
+	CHECK(lcd.bus.flushes > 0);
+}
+
+/*****************************************************************************/
+/* Numa tela 20x4 de um controlador as linhas 2 e 3 continuam as linhas 0 e  */
+/* 1 na DDRAM: 0x00, 0x40, 0x14 e 0x54.                                      */
+/*****************************************************************************/
+static void testDdramRows() {
+	Hd44780Model m;
+	Hd44780<Hd44780ModelBus> lcd(20, 4, Hd44780ModelBus(&m));
+	char line[21];
+	lcd.init();
+	for (byte row = 0; row < 4; row++) {
+		lcd.setCursor(0, row);
+		lcd.print("Linha ");
+		lcd.print(row);
+	}
+	lcd.setCursor(15, 3);
+	lcd.print("Fim");
+	CHECK(m.log[m.logSize - 1] == (0x80 | (0x54 + 15)));
+	CHECK(m.ddram[0x14] == 'L');
+	CHECK(m.ddram[0x54] == 'L');
+	CHECK_STR(m.line(line, 0, 20), "Linha 0             ");
+	CHECK_STR(m.line(line, 1, 20), "Linha 1             ");
+	CHECK_STR(m.line(line, 2, 20), "Linha 2             ");
+	CHECK_STR(m.line(line, 3, 20), "Linha 3        Fim  ");
+	CHECK(lcd.bus.busyWrites == 0);
+
+	lcd.clear();
+	CHECK_STR(m.line(line, 0, 20), "                    ");
+	lcd.print("X");
+	CHECK(m.ddram[0] == 'X');
+	CHECK(lcd.bus.busyWrites == 0);
+}
+
+/*****************************************************************************/
+/* 40x4: o segundo controlador fica com as linhas 2 e 3; a inicialização e o */
+/* clear vão para os dois.                                                   */
+/*****************************************************************************/
+static void testTwoControllers() {
+	static const byte expected[] = {0x38, 0x0C, 0x01, 0x06};
+	Hd44780Model top, bottom;
+	Hd44780<Hd44780ModelBus> lcd(40, 4, Hd44780ModelBus(&top, &bottom));
+	char line[41];
+	lcd.init();
+	CHECK(logIs(top, expected, sizeof(expected)));
+	CHECK(logIs(bottom, expected, sizeof(expected)));
+	lcd.setCursor(39, 1);
+	lcd.print("A");
+	lcd.setCursor(0, 2);
+	lcd.print("B");
+	lcd.setCursor(2, 3);
+	lcd.print("C");
+	CHECK(top.ddram[0x67] == 'A');
+	CHECK_STR(bottom.line(line, 0, 40), "B                                       ");
+	CHECK(bottom.ddram[0x42] == 'C');
+	CHECK(top.ddram[0] == ' ');
+	CHECK(lcd.bus.busyWrites == 0);
+
+	lcd.clear();
+	CHECK(top.ddram[0x67] == ' ' && bottom.ddram[0] == ' ');
+	CHECK(lcd.bus.current == 0);
+}
+
+/*****************************************************************************/
+/* createChar() grava as oito linhas na CGRAM; o caractere aparece na tela   */
+/* depois de um setCursor().                                                 */
+/*****************************************************************************/
+static void testCreateChar() {
+	static const byte bell[8] = {0x04, 0x0E, 0x0E, 0x0E, 0x1F, 0x00, 0x04, 0x00};
+	Hd44780Model m;
+	Hd44780<Hd44780ModelBus> lcd(16, 2, Hd44780ModelBus(&m));
+	lcd.init();
+	lcd.createChar(1, bell);
+	CHECK(memcmp(m.cgram + 8, bell, 8) == 0);
+	CHECK(m.cgram[0] == 0 && m.cgram[16] == 0);
+	lcd.setCursor(3, 1);
+	lcd.write(1);
+	CHECK(m.ddram[0x43] == 1);
+	CHECK(lcd.bus.busyWrites == 0);
+}
+
+/*****************************************************************************/
+/* LcdFrameBuffer::flush() em lotes pequenos acaba com o LCD igual à tela em */
+/* RAM, inclusive depois de uma alteração no meio de uma linha.              */
+/*****************************************************************************/
+static void testFrameBufferFlush() {
+	Hd44780Model m;
+	Hd44780<Hd44780ModelBus> lcd(20, 4, Hd44780ModelBus(&m));
+	LcdFrameBuffer<20, 4> screen;
+	char line[21];
+	lcd.init();
+	screen.setLine(0, "IFSPresente  12:34  ");
+	screen.setLine(2, "Sala de reunioes    ");
+	screen.setLine(3, "             Livre  ");
+	while (screen.pending())
+		screen.flush(lcd, 7);
+	for (byte row = 0; row < 4; row++)
+		CHECK(memcmp(m.line(line, row, 20), screen.target[row], 20) == 0);
+
+	memcpy(screen.edit(0) + 13, "12:35", 5);
+	screen.touch(0);
+	CHECK(screen.flush(lcd, 20) == 2);
+	CHECK(startsWith(m.line(line, 0, 20), "IFSPresente  12:35"));
+	CHECK(lcd.bus.busyWrites == 0);
+}
+
+/*****************************************************************************/
+/* Módulo I2C: os bytes do PCF8574, decodificados na descida de E, fazem a   */
+/* inicialização por instrução até os 4 bits e então as mesmas instruções.   */
+/*****************************************************************************/
+static Hd44780Model pcfModel;
+
+static uint8_t pcfDevice(uint8_t address, const uint8_t *data, uint8_t size) {
+	if (address != 0x27)
+		return 2;  // Sem ACK no endereço
+	for (uint8_t i = 0; i < size; i++)
+		pcfModel.pcf(data[i]);
+	return 0;
+}
+
+static void testI2cBus() {
+	static const byte expected[] = {0x30, 0x30, 0x30, 0x20, 0x28, 0x0C, 0x01, 0x06};
+	Hd44780<Hd44780BusI2c> lcd(20, 4);
+	char line[21];
+	pcfModel.reset();
+	Wire.onWrite = pcfDevice;
+	lcd.init();
+	CHECK(logIs(pcfModel, expected, sizeof(expected)));
+	CHECK(pcfModel.fourBit);
+	lcd.setCursor(0, 2);
+	lcd.print("Sala 1");
+	lcd.flush();
+	CHECK_STR(pcfModel.line(line, 2, 20), "Sala 1              ");
+	Wire.onWrite = NULL;
+}
+
+int main() {
+	shimDelayHook = watchBus;
+	testBus8Contention();
+	testBus4Contention();
+	testInitSequence();
+	testDdramRows();
+	testTwoControllers();
+	testCreateChar();
+	testFrameBufferFlush();
+	testI2cBus();
+	return CHECK_RESULT();
+}
@@ -0,0 +1,84 @@
+#include <Arduino.h>
+#include "health.h"
+#include "check.h"
+
+extern "C" char __heap_start[SHIM_FREE_RAM];
+extern "C" char *__brkval;
+
+/*****************************************************************************/
+/* A pilha usou `depth` bytes abaixo do SP atual, sem contar o que pintou.   */
+/*****************************************************************************/
+static void useStack(unsigned int depth) {
+	memset((char *) SP - depth, 0, depth);
+}
+
+/*****************************************************************************/
+/* Depois de begin() toda a SRAM livre está pintada; a folga é a distância   */
+/* até o byte mais baixo que a pilha já alterou, mesmo depois de ela voltar. */
+/*****************************************************************************/
+static void testCanary() {
+	unsigned int size = (char *) SP - __heap_start;
+	health.begin();
+	CHECK(Health::stackHeadroom() == size);
+	CHECK(Health::freeRam() == size);
+	CHECK((byte) __heap_start[0] == STACK_CANARY);
+
+	useStack(100);
+	CHECK(Health::stackHeadroom() == size - 100);
+	useStack(40);                              // Mais rasa: a folga não cresce
+	CHECK(Health::stackHeadroom() == size - 100);
+
+	// Um byte alterado no meio da região marca a pilha mais funda
+	__heap_start[300] = 0;
+	CHECK(Health::stackHeadroom() == 300);
+	health.begin();
+	CHECK(Health::stackHeadroom() == size);
+}
+
+/*****************************************************************************/
+/* Com o heap em uso a conta começa no fim dele (__brkval), e a SRAM livre   */
+/* acompanha o SP.                                                           */
+/*****************************************************************************/
+static void testHeapAndSp() {
+	unsigned int size = (char *) SP - __heap_start;
+	uintptr_t sp = SP;
+	health.begin();
+	__brkval = __heap_start + 200;
+	CHECK(Health::freeRam() == size - 200);
+	CHECK(Health::stackHeadroom() == size - 200);
+	SP -= 50;
+	CHECK(Health::freeRam() == size - 250);
+	CHECK(Health::stackHeadroom() == size - 250);
+	SP = sp;
+	__brkval = NULL;
+}
+
+/*****************************************************************************/
+/* loopsPerSecond só muda quando a janela de 1 s fecha, e vale pelo tempo    */
+/* real da janela.                                                           */
+/*****************************************************************************/
+static void testLoopsPerSecond() {
+	Health h;
+	shimMillis = 0;
+	h.updateRate(500);
+	CHECK(h.loopsPerSecond == 0);
+	shimMillis = 999;
+	h.updateRate(800);
+	CHECK(h.loopsPerSecond == 0);
+	shimMillis = 1000;
+	h.updateRate(800);
+	CHECK(h.loopsPerSecond == 800);
+	shimMillis = 2500;
+	h.updateRate(2300);
+	CHECK(h.loopsPerSecond == 1000);
+	shimMillis = 3499;
+	h.updateRate(9999);
+	CHECK(h.loopsPerSecond == 1000);
+}
+
+int main() {
+	testCanary();
+	testHeapAndSp();
+	testLoopsPerSecond();
+	return CHECK_RESULT();
+}
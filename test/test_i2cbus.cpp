@@ -0,0 +1,82 @@
+#include <Arduino.h>
+#include "i2cbus.h"
+#include "check.h"
+
+/*****************************************************************************/
+/* Dispositivo simulado: só o endereço 0x27 responde.                        */
+/*****************************************************************************/
+static uint8_t deviceWrite(uint8_t address, const uint8_t *, uint8_t) {
+	return address == 0x27 ? 0 : 2;
+}
+
+static uint8_t deviceRead(uint8_t address, uint8_t *data, uint8_t size) {
+	if (address != 0x27)
+		return 0;
+	for (uint8_t i = 0; i < size; i++)
+		data[i] = i;
+	return size;
+}
+
+/*****************************************************************************/
+/* Um bloco maior que o buffer da Wire vira várias transações.               */
+/*****************************************************************************/
+static void testWrite() {
+	I2cBus bus;
+	byte data[BUFFER_LENGTH + 8];
+	CHECK(bus.write(0x27, data, sizeof(data)));
+	CHECK(bus.transactions == 2);
+	CHECK(bus.bytes == sizeof(data));
+	CHECK(bus.errors == 0);
+
+	CHECK(!bus.write(0x20, data, 3));
+	CHECK(bus.transactions == 3);
+	CHECK(bus.errors == 1);
+}
+
+/*****************************************************************************/
+/* Uma leitura são duas transações: o registrador e os dados.                */
+/*****************************************************************************/
+static void testRead() {
+	I2cBus bus;
+	byte data[4];
+	CHECK(bus.read(0x27, 0x11, data, sizeof(data)));
+	CHECK(data[3] == 3);
+	CHECK(bus.transactions == 2);
+	CHECK(bus.bytes == 1 + sizeof(data));
+
+	CHECK(!bus.read(0x68, 0x11, data, sizeof(data)));
+	CHECK(bus.errors == 1);
+}
+
+/*****************************************************************************/
+/* As taxas só mudam quando a janela de 1 s fecha, e valem pelo tempo real   */
+/* da janela.                                                                */
+/*****************************************************************************/
+static void testRates() {
+	byte data[10];
+	shimMillis = 0;
+	I2cBus bus;
+	for (byte i = 0; i < 15; i++)
+		bus.write(0x27, data, sizeof(data));
+	shimMillis = 999;
+	bus.updateRates();
+	CHECK(bus.transactionsPerSecond == 0);
+	shimMillis = 1500;
+	bus.updateRates();
+	CHECK(bus.transactionsPerSecond == 10);
+	CHECK(bus.bytesPerSecond == 100);
+
+	shimMillis = 2500;
+	bus.updateRates();
+	CHECK(bus.transactionsPerSecond == 0);
+	CHECK(bus.bytesPerSecond == 0);
+}
+
+int main() {
+	Wire.onWrite = deviceWrite;
+	Wire.onRead = deviceRead;
+	testWrite();
+	testRead();
+	testRates();
+	return CHECK_RESULT();
+}
@@ -0,0 +1,119 @@
+#include <Arduino.h>
+#include "latency.h"
+#include "check.h"
+
+/*****************************************************************************/
+/* Um quadro com os instantes dados, em contagens do Timer1.                 */
+/*****************************************************************************/
+static void frame(int code, uint16_t end, uint16_t parsed, uint16_t reply, uint16_t handled) {
+	latency.start(end);
+	shimTimer1Count = parsed;
+	latency.parsed();
+	if (reply != handled) {
+		shimTimer1Count = reply;
+		latency.reply();
+		shimTimer1Count = reply + 1;
+		latency.reply();       // A segunda resposta não muda nada
+	}
+	shimTimer1Count = handled;
+	latency.handled(code);
+}
+
+static const char *page(byte n) {
+	static char out[40];
+	latency.format(n, out);
+	return out;
+}
+
+/*****************************************************************************/
+/* Mínimo, máximo e média por código, inclusive com o Timer1 dando a volta.  */
+/*****************************************************************************/
+static void testMinMaxAverage() {
+	char out[40];
+	latency.reset();
+	frame(500, 100, 110, 150, 200);            // 50 até a resposta
+	frame(500, 65530, 65534, 4, 20);           // 10, passando por 0
+	frame(100, 0, 5, 30, 40);
+	frame(500, 300, 320, 390, 400);            // 90
+	CHECK(latency.entries[0].code == 500);
+	CHECK(latency.entries[0].count == 3);
+	CHECK(latency.entries[0].min == 10);
+	CHECK(latency.entries[0].max == 90);
+	CHECK(latency.entries[0].sumReply == 150);
+	CHECK(latency.entries[0].sumParse == 10 + 4 + 20);
+	CHECK(latency.entries[0].sumHandler == 90 + 22 + 80);
+	CHECK(latency.entries[1].code == 100);
+
+	// Em microssegundos: 4 por contagem
+	CHECK_STR(page(0), "500:3:40:200:360");
+	CHECK_STR(page(1), "500:44:256:0");
+	CHECK_STR(page(3), "100:1:120:120:120");
+	CHECK(!latency.format(6, out) && out[0] == '\0');
+}
+
+/*****************************************************************************/
+/* Sem resposta, o fim do tratamento conta como resposta; o código 0 não é   */
+/* acumulado; códigos além de LATENCY_SLOTS só contam em `untracked`.        */
+/*****************************************************************************/
+static void testSlots() {
+	latency.reset();
+	frame(701, 0, 10, 40, 40);
+	CHECK(latency.entries[0].min == 40);
+	frame(0, 0, 10, 20, 30);
+	CHECK(latency.entries[1].code == 0);
+	for (int code = 1; code <= LATENCY_SLOTS; code++)
+		frame(code, 0, 1, 2, 3);
+	CHECK(latency.entries[LATENCY_SLOTS - 1].code == LATENCY_SLOTS - 1);
+	CHECK(latency.untracked == 1);
+	latency.reset();
+	CHECK(latency.entries[0].code == 0);
+	CHECK(latency.untracked == 0);
+}
+
+/*****************************************************************************/
+/* Histograma em faixas de 4x a partir de 128 µs (32 contagens).             */
+/*****************************************************************************/
+static void testHistogram() {
+	latency.reset();
+	static const uint16_t totals[] = {0, 31, 32, 127, 128, 511, 512, 2047, 2048, 8191, 8192, 65535};
+	for (byte i = 0; i < sizeof(totals) / sizeof(totals[0]); i++)
+		frame(200, 0, 0, totals[i], totals[i]);
+	CHECK_STR(page(2), "200:2:2:2:2:2:2");
+}
+
+/*****************************************************************************/
+/* A transmissão conta do primeiro byte da resposta até a fila esvaziar, só  */
+/* para o último quadro tratado e só se ele respondeu.                       */
+/*****************************************************************************/
+static void testDrained() {
+	latency.reset();
+	frame(500, 0, 10, 20, 30);
+	CHECK(latency.draining());
+	shimTimer1Count = 120;
+	latency.drained();
+	CHECK(!latency.draining());
+	CHECK(latency.entries[0].sent == 1);
+	CHECK(latency.entries[0].sumSend == 100);
+	latency.drained();
+	CHECK(latency.entries[0].sent == 1);
+
+	frame(500, 200, 210, 220, 230);
+	frame(100, 240, 250, 260, 270);           // A fila de 500 não esvaziou
+	shimTimer1Count = 300;
+	latency.drained();
+	CHECK(latency.entries[0].sent == 1);
+	CHECK(latency.entries[1].sent == 1);
+	CHECK(latency.entries[1].sumSend == 40);
+
+	frame(100, 400, 410, 420, 420);           // Sem resposta
+	CHECK(!latency.draining());
+	CHECK_STR(page(1), "500:40:80:400");
+}
+
+int main() {
+	testMinMaxAverage();
+	testSlots();
+	testHistogram();
+	testDrained();
+	return CHECK_RESULT();
+}
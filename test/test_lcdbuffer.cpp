@@ -0,0 +1,164 @@
+#include <Arduino.h>
+#include "hd44780.h"
+#include "lcdbuffer.h"
+#include "hd44780_model.h"
+#include "check.h"
+
+typedef LcdFrameBuffer<20, 4> Screen;
+typedef Hd44780<Hd44780ModelBus> Lcd;
+
+enum { BUDGET = 8 };  // LCD_FLUSH_BUDGET do sketch
+
+/*****************************************************************************/
+/* Tela enviada por inteiro e o LCD depois preenchido com '#': o que não foi */
+/* reescrito continua '#'.                                                   */
+/*****************************************************************************/
+static void fill(Lcd &lcd, Hd44780Model &m, Screen &screen) {
+	lcd.init();
+	screen.setLine(0, "IFSPresente  12:34  ");
+	screen.setLine(1, "Aula de Redes       ");
+	screen.setLine(2, "Sala de reunioes    ");
+	screen.setLine(3, "             Livre  ");
+	while (screen.pending())
+		screen.flush(lcd, 255);
+	memset(m.ddram, '#', sizeof(m.ddram));
+}
+
+/*****************************************************************************/
+/* Só as posições alteradas são escritas, com um setCursor() por trecho.     */
+/*****************************************************************************/
+static void testOnlyChangedCells() {
+	Hd44780Model m;
+	Lcd lcd(20, 4, Hd44780ModelBus(&m));
+	Screen screen;
+	char line[21];
+	fill(lcd, m, screen);
+
+	memcpy(screen.edit(0) + 13, "12:35", 5);   // Só o último dígito muda
+	screen.touch(0);
+	CHECK(screen.flush(lcd, 255) == 2);
+	CHECK_STR(m.line(line, 0, 20), "#################5##");
+
+	memcpy(screen.edit(1), "aula de Redes II", 16);
+	screen.touch(1);
+	CHECK(screen.flush(lcd, 255) == 2 + 3);    // Dois trechos: "a" e "II"
+	CHECK_STR(m.line(line, 1, 20), "a#############II####");
+	CHECK_STR(m.line(line, 2, 20), "####################");
+	CHECK_STR(m.line(line, 3, 20), "####################");
+	CHECK(lcd.bus.busyWrites == 0);
+}
+
+/*****************************************************************************/
+/* Uma linha reescrita com o mesmo texto não custa nada, nem o flush() do    */
+/* barramento.                                                               */
+/*****************************************************************************/
+static void testStaticLines() {
+	Hd44780Model m;
+	Lcd lcd(20, 4, Hd44780ModelBus(&m));
+	Screen screen;
+	fill(lcd, m, screen);
+	unsigned int flushes = lcd.bus.flushes;
+	byte changes = screen.changes();
+
+	screen.setLine(2, "Sala de reunioes    ");
+	CHECK(!screen.pending());
+	CHECK(screen.changes() == changes);
+	CHECK(screen.flush(lcd, 255) == 0);
+	CHECK(lcd.bus.flushes == flushes);
+
+	// Alterada e desfeita antes do envio: nada a escrever
+	screen.edit(3)[0] = 'X';
+	screen.touch(3);
+	CHECK(screen.pending());
+	screen.edit(3)[0] = ' ';
+	screen.touch(3);
+	CHECK(!screen.pending());
+	CHECK(m.ddram[0x54] == '#');
+}
+
+/*****************************************************************************/
+/* A tela inteira muda: cada flush() faz no máximo BUDGET operações (uma a   */
+/* mais se a última é um setCursor() com o seu caractere) e o seguinte       */
+/* retoma de onde parou, sem reposicionar o cursor.                          */
+/*****************************************************************************/
+static void testBudget() {
+	Hd44780Model m;
+	Lcd lcd(20, 4, Hd44780ModelBus(&m));
+	Screen screen;
+	char line[21];
+	lcd.init();
+	unsigned int flushes = lcd.bus.flushes;
+	for (byte row = 0; row < 4; row++)
+		screen.setLine(row, "0123456789abcdefghij");
+
+	unsigned int total = 0, calls = 0;
+	while (screen.pending()) {
+		byte used = screen.flush(lcd, BUDGET);
+		CHECK(used <= BUDGET + 1 && (used >= BUDGET || !screen.pending()));
+		total += used;
+		calls++;
+	}
+	CHECK(total == 4 * (1 + 20) - 1);          // Um setCursor() por linha, menos na 0: o clear() deixa o cursor na origem
+	CHECK(lcd.bus.flushes == flushes + calls);
+	for (byte row = 0; row < 4; row++)
+		CHECK_STR(m.line(line, row, 20), "0123456789abcdefghij");
+	CHECK(screen.flush(lcd, BUDGET) == 0);
+	CHECK(lcd.bus.busyWrites == 0);
+}
+
+/*****************************************************************************/
+/* A linha promovida passa à frente no flush() seguinte, mesmo com outra     */
+/* linha pela metade, que depois continua de onde parou.                     */
+/*****************************************************************************/
+static void testPriorityRow() {
+	Hd44780Model m;
+	Lcd lcd(20, 4, Hd44780ModelBus(&m));
+	Screen screen;
+	char line[21];
+	lcd.init();
+	for (byte row = 0; row < 4; row++)
+		screen.setLine(row, "0123456789abcdefghij");
+
+	CHECK(screen.flush(lcd, BUDGET) == BUDGET);  // Cursor já na origem: oito caracteres
+	CHECK_STR(m.line(line, 0, 20), "01234567            ");
+	screen.setLine(3, "Maria               ");
+	screen.promote(3);
+	CHECK(screen.flush(lcd, 1 + 5) == 1 + 5);
+	CHECK_STR(m.line(line, 3, 20), "Maria               ");
+	CHECK_STR(m.line(line, 0, 20), "01234567            ");
+	CHECK_STR(m.line(line, 1, 20), "                    ");
+
+	// A linha fica à frente até um flush() chegar ao seu fim: a alteração
+	// feita antes disso sai junto, e só então a linha 0 retoma
+	screen.edit(3)[0] = 'J';
+	screen.touch(3);
+	CHECK(screen.flush(lcd, 2 + 1 + 12) == 2 + 1 + 12);
+	CHECK(m.ddram[0x54] == 'J');
+	CHECK_STR(m.line(line, 0, 20), "0123456789abcdefghij");
+
+	// A promoção vale uma vez: a linha 3 alterada de novo espera a vez
+	screen.edit(3)[0] = 'K';
+	screen.touch(3);
+	CHECK(screen.flush(lcd, BUDGET) >= BUDGET);
+	CHECK(m.ddram[0x54] == 'J');
+	CHECK(m.ddram[0x40] == '0');
+	while (screen.pending())
+		screen.flush(lcd, BUDGET);
+	CHECK_STR(m.line(line, 1, 20), "0123456789abcdefghij");
+	CHECK_STR(m.line(line, 3, 20), "Karia               ");
+
+	// Promover uma linha sem diferença não atrasa as outras
+	screen.setLine(1, "x123456789abcdefghij");
+	screen.promote(2);
+	CHECK(screen.flush(lcd, BUDGET) == 2);
+	CHECK(m.ddram[0x40] == 'x');
+	CHECK(lcd.bus.busyWrites == 0);
+}
+
+int main() {
+	testOnlyChangedCells();
+	testStaticLines();
+	testBudget();
+	testPriorityRow();
+	return CHECK_RESULT();
+}
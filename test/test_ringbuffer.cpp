@@ -0,0 +1,93 @@
+#include <Arduino.h>
+#include "ringbuffer.h"
+#include "check.h"
+
+/*****************************************************************************/
+/* Uma posição fica vaga: cabem SIZE - 1 elementos.                          */
+/*****************************************************************************/
+static void testCapacity() {
+	RingBuffer<int, 4> q;
+	CHECK(q.empty());
+	CHECK(q.push(1));
+	CHECK(q.push(2));
+	CHECK(q.push(3));
+	CHECK(q.full());
+	CHECK(!q.push(4));
+	CHECK(q.count() == 3);
+	int v = 0;
+	CHECK(q.pop(v) && v == 1);
+	CHECK(q.pop(v) && v == 2);
+	CHECK(q.pop(v) && v == 3);
+	CHECK(!q.pop(v));
+	CHECK(q.empty());
+}
+
+/*****************************************************************************/
+/* Os índices dão várias voltas sem perder a ordem.                          */
+/*****************************************************************************/
+static void testWrapAround() {
+	RingBuffer<byte, 8> q;
+	byte next = 0;
+	byte expected = 0;
+	for (int i = 0; i < 200; i++) {
+		CHECK(q.push(next++));
+		CHECK(q.push(next++));
+		byte v;
+		CHECK(q.pop(v) && v == expected++);
+		CHECK(q.pop(v) && v == expected++);
+	}
+	CHECK(q.empty());
+}
+
+/*****************************************************************************/
+/* O produtor monta no lugar com slot() e publica com commit().              */
+/*****************************************************************************/
+static void testSlotCommit() {
+	RingBuffer<int, 2> q;
+	*q.slot() = 42;
+	CHECK(q.front() == NULL);
+	CHECK(q.commit());
+	CHECK(q.front() != NULL && *q.front() == 42);
+	*q.slot() = 43;
+	CHECK(!q.commit());
+	q.drop();
+	CHECK(q.front() == NULL);
+}
+
+/*****************************************************************************/
+/* highWater guarda a maior ocupação até resetHighWater().                   */
+/*****************************************************************************/
+static void testHighWater() {
+	RingBuffer<int, 8> q;
+	for (int i = 0; i < 5; i++)
+		q.push(i);
+	int v;
+	for (int i = 0; i < 4; i++)
+		q.pop(v);
+	CHECK(q.highWater == 5);
+	q.resetHighWater();
+	CHECK(q.highWater == 1);
+}
+
+/*****************************************************************************/
+/* clear() esvazia a fila sem mexer no lado do produtor.                     */
+/*****************************************************************************/
+static void testClear() {
+	RingBuffer<int, 4> q;
+	q.push(1);
+	q.push(2);
+	q.clear();
+	CHECK(q.empty());
+	CHECK(q.push(3));
+	int v;
+	CHECK(q.pop(v) && v == 3);
+}
+
+int main() {
+	testCapacity();
+	testWrapAround();
+	testSlotCommit();
+	testHighWater();
+	testClear();
+	return CHECK_RESULT();
+}
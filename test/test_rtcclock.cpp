@@ -0,0 +1,173 @@
+#include <Arduino.h>
+#include "rtcclock.h"
+#include "i2cbus.h"
+#include "check.h"
+
+static RTC_DS3231 ds3231;
+
+/*****************************************************************************/
+/* Registradores do DS3231 no barramento simulado: uma escrita posiciona o   */
+/* ponteiro, e a leitura segue dali.                                         */
+/*****************************************************************************/
+static byte regs[0x13];
+static byte regPointer;
+static bool answering = true;
+
+static uint8_t ds3231Write(uint8_t address, const uint8_t *data, uint8_t size) {
+	if (address != DS3231_I2C_ADDRESS || !answering)
+		return 2;   // Endereço sem ACK
+	if (size > 0)
+		regPointer = data[0];
+	return 0;
+}
+
+static uint8_t ds3231Read(uint8_t address, uint8_t *data, uint8_t size) {
+	if (address != DS3231_I2C_ADDRESS || !answering)
+		return 0;
+	memcpy(data, regs + regPointer, size);
+	return size;
+}
+
+static byte bcd(byte value) {
+	return (value / 10) << 4 | value % 10;
+}
+
+static void setTime(byte year, byte month, byte day, byte hour, byte minute, byte second) {
+	regs[0] = bcd(second);
+	regs[1] = bcd(minute);
+	regs[2] = bcd(hour);
+	regs[4] = bcd(day);
+	regs[5] = bcd(month);
+	regs[6] = bcd(year);
+}
+
+static void setTemperature(byte msb, byte lsb) {
+	regs[DS3231_TEMPERATURE_MSB] = msb;
+	regs[DS3231_TEMPERATURE_MSB + 1] = lsb;
+}
+
+static const char *timeText() {
+	static char out[20];
+	rtcClock.formatTime(out);
+	return out;
+}
+
+static const char *temperatureText() {
+	static char out[8];
+	rtcClock.formatTemperature(out);
+	return out;
+}
+
+/*****************************************************************************/
+/* Complemento de dois em quartos de grau, inclusive abaixo de um grau.      */
+/*****************************************************************************/
+static void testTemperature() {
+	setTemperature(0x19, 0xC0);
+	rtcClock.begin(ds3231);
+	CHECK(rtcClock.temperature == 2575);
+	CHECK_STR(temperatureText(), "25.75");
+	setTemperature(0xFD, 0x40);
+	rtcClock.refresh();
+	CHECK_STR(temperatureText(), "-2.75");
+	setTemperature(0xFF, 0xC0);
+	rtcClock.refresh();
+	CHECK_STR(temperatureText(), "-0.25");
+	setTemperature(0x00, 0x00);
+	rtcClock.refresh();
+	CHECK_STR(temperatureText(), "0.00");
+
+	// Uma leitura que falha mantém o valor anterior
+	setTemperature(0x30, 0x00);
+	answering = false;
+	rtcClock.refresh();
+	answering = true;
+	CHECK_STR(temperatureText(), "0.00");
+}
+
+/*****************************************************************************/
+/* Sem pulsos, o relógio anda pelo millis(), com a virada do dia bissexto.   */
+/*****************************************************************************/
+static void testFormatTime() {
+	shimMillis = 0;
+	setTime(24, 2, 29, 23, 59, 58);
+	rtcClock.begin(ds3231);
+	CHECK_STR(timeText(), "2024:02:29:23:59:58");
+	shimMillis = 1999;
+	CHECK_STR(timeText(), "2024:02:29:23:59:59");
+	uint16_t fraction;
+	rtcClock.unixtime(&fraction);
+	CHECK(fraction == 999);
+	shimMillis = 2000;
+	CHECK_STR(timeText(), "2024:03:01:00:00:00");
+}
+
+/*****************************************************************************/
+/* A hora é relida no primeiro pulso e no pulso seguinte a cada leitura da   */
+/* temperatura, o que corrige um pulso perdido.                              */
+/*****************************************************************************/
+static void testResync() {
+	shimMillis = 0;
+	setTime(24, 2, 29, 23, 59, 58);
+	rtcClock.begin(ds3231);
+	CHECK(!rtcClock.pending());
+
+	shimMillis = 1000;
+	setTime(24, 2, 29, 23, 59, 59);
+	rtcClock.tickIsr();
+	CHECK(rtcClock.pending());
+	rtcClock.refresh();
+	CHECK(!rtcClock.pending());
+	CHECK_STR(timeText(), "2024:02:29:23:59:59");
+
+	// O pulso de 2000 se perde: o de 3000 deixa a hora um segundo atrasada
+	shimMillis = 3000;
+	setTime(24, 3, 1, 0, 0, 1);
+	rtcClock.tickIsr();
+	CHECK(!rtcClock.pending());
+	CHECK_STR(timeText(), "2024:03:01:00:00:00");
+
+	// Leitura da temperatura: o próximo pulso traz a hora do DS3231
+	rtcClock.refresh();
+	CHECK(!rtcClock.pending());
+	shimMillis = 4000;
+	setTime(24, 3, 1, 0, 0, 2);
+	rtcClock.tickIsr();
+	CHECK(rtcClock.pending());
+	rtcClock.refresh();
+	CHECK(!rtcClock.pending());
+	CHECK_STR(timeText(), "2024:03:01:00:00:02");
+}
+
+/*****************************************************************************/
+/* Hora e temperatura são lidas pelo i2c, e entram nos contadores.           */
+/*****************************************************************************/
+static void testCounters() {
+	unsigned long transactions = i2c.transactions;
+	unsigned long bytes = i2c.bytes;
+	rtcClock.begin(ds3231);
+	CHECK(i2c.transactions == transactions + 4);
+	CHECK(i2c.bytes == bytes + 1 + 7 + 1 + 2);
+
+	// Sem resposta, a hora fica como estava
+	unsigned int errors = i2c.errors;
+	shimMillis = 5000;
+	setTime(24, 3, 1, 0, 0, 9);
+	rtcClock.refresh();
+	answering = false;
+	rtcClock.tickIsr();
+	rtcClock.refresh();
+	answering = true;
+	CHECK(i2c.errors == errors + 1);
+	CHECK(!rtcClock.pending());
+	CHECK_STR(timeText(), "2024:03:01:00:00:03");
+}
+
+int main() {
+	Wire.onWrite = ds3231Write;
+	Wire.onRead = ds3231Read;
+	testTemperature();
+	testFormatTime();
+	testResync();
+	testCounters();
+	return CHECK_RESULT();
+}
@@ -0,0 +1,134 @@
+#include <Arduino.h>
+#include "scheduler.h"
+#include "check.h"
+
+/*****************************************************************************/
+/* Três tarefas que anotam a ordem em que rodaram.                           */
+/*****************************************************************************/
+static char trace[16];
+static byte traced;
+static unsigned int spinUs;
+
+static void note(char c) {
+	if (traced < sizeof(trace) - 1)
+		trace[traced++] = c;
+	trace[traced] = '\0';
+}
+
+static void taskA() { note('A'); }
+static void taskB() { note('B'); }
+
+static void taskSlow() {
+	note('C');
+	unsigned long start = micros();
+	while (micros() - start < spinUs)
+		;
+}
+
+static const Scheduler<3>::Task table[3] PROGMEM = {taskA, taskB, taskSlow};
+
+/*****************************************************************************/
+/* Roda até não haver tarefa pronta e devolve a ordem.                       */
+/*****************************************************************************/
+static const char *runAll(Scheduler<3> &tasks) {
+	traced = 0;
+	trace[0] = '\0';
+	while (tasks.run())
+		;
+	return trace;
+}
+
+/*****************************************************************************/
+/* As funções saem da tabela em PROGMEM, uma por run(), da mais prioritária  */
+/* para a menos; cada run() conta uma passada.                               */
+/*****************************************************************************/
+static void testPriority() {
+	Scheduler<3> tasks(table);
+	CHECK(!tasks.run());
+	tasks.wake(2);
+	tasks.wake(1);
+	tasks.wake(0);
+	tasks.wake(1);            // Acordar de novo não a faz rodar duas vezes
+	CHECK_STR(runAll(tasks), "ABC");
+	CHECK(tasks.passes == 1 + 4);
+}
+
+/*****************************************************************************/
+/* Um prazo torna a tarefa pronta uma vez; after() e at() substituem o prazo */
+/* anterior e cancel() o desfaz sem tirar um wake() já feito.                */
+/*****************************************************************************/
+static void testDue() {
+	Scheduler<3> tasks(table);
+	shimMillis = 1000;
+	tasks.after(1, 50);
+	tasks.after(0, 100);
+	shimMillis = 1049;
+	CHECK_STR(runAll(tasks), "");
+	shimMillis = 1050;
+	CHECK_STR(runAll(tasks), "B");
+	shimMillis = 2000;
+	CHECK_STR(runAll(tasks), "A");         // Atrasada roda, e só uma vez
+	CHECK_STR(runAll(tasks), "");
+
+	tasks.after(1, 10);
+	tasks.at(1, 3000);
+	shimMillis = 2010;
+	CHECK_STR(runAll(tasks), "");
+	tasks.wake(1);
+	tasks.cancel(1);
+	CHECK_STR(runAll(tasks), "B");
+	shimMillis = 3000;
+	CHECK_STR(runAll(tasks), "");
+}
+
+/*****************************************************************************/
+/* Prazos do outro lado da volta do millis(), aos 49,7 dias no Nano. Os      */
+/* instantes são escritos como 0UL - n para a volta ser a do unsigned long   */
+/* também no PC, onde ele tem 64 bits.                                       */
+/*****************************************************************************/
+static void testWrap() {
+	Scheduler<3> tasks(table);
+	shimMillis = 0UL - 0x100;
+	tasks.after(0, 0x200);                 // Prazo em 0x100, depois da volta
+	tasks.at(1, 0UL - 0x10);
+	shimMillis = 0UL - 1;
+	CHECK_STR(runAll(tasks), "B");
+	shimMillis = 0xFF;
+	CHECK_STR(runAll(tasks), "");
+	shimMillis = 0x100;
+	CHECK_STR(runAll(tasks), "A");
+
+	// Vencido antes da volta e visto só depois dela
+	shimMillis = 0UL - 0x10;
+	tasks.after(1, 0x0F);
+	shimMillis = 0x20;
+	CHECK_STR(runAll(tasks), "B");
+}
+
+/*****************************************************************************/
+/* `longest` guarda a maior duração de cada tarefa, em microssegundos.       */
+/*****************************************************************************/
+static void testLongest() {
+	Scheduler<3> tasks(table);
+	spinUs = 2000;
+	tasks.wake(2);
+	runAll(tasks);
+	CHECK(tasks.longest[2] >= 2000);
+	unsigned long longest = tasks.longest[2];
+
+	spinUs = 0;
+	tasks.wake(2);
+	tasks.wake(0);
+	runAll(tasks);
+	CHECK(tasks.longest[2] == longest);
+	CHECK(tasks.longest[0] < 2000);
+	CHECK(tasks.longest[1] == 0);
+}
+
+int main() {
+	testPriority();
+	testDue();
+	testWrap();
+	testLongest();
+	return CHECK_RESULT();
+}
@@ -0,0 +1,303 @@
+#include <Arduino.h>
+#include "check.h"
+
+// O sketch inteiro, com setup(), loop() e as tarefas, sobre o núcleo simulado
+#include "../CristalLiq-serial/CristalLiq-serial.ino"
+
+/*****************************************************************************/
+/* Entrega um quadro à Serial, trata-o e devolve a resposta.                 */
+/*****************************************************************************/
+static const char *command(const char *frame) {
+	Serial.clearOutput();
+	Serial.feed(frame);
+	trataQuadros();
+	return Serial.output;
+}
+
+/*****************************************************************************/
+/* Texto da linha na tela em RAM, terminado em '\0'.                         */
+/*****************************************************************************/
+static const char *screenLine(byte row) {
+	static char out[Geometry::COLS + 1];
+	memcpy(out, lcdBuffer.target[row], Geometry::COLS);
+	out[Geometry::COLS] = '\0';
+	return out;
+}
+
+static void testSetup() {
+	CHECK(Serial.baud == DEFAULT_BAUD_RATE);
+	CHECK(rtc.sqwMode == DS3231_SquareWave1Hz);
+	CHECK(shimInterrupt[1] != NULL);
+	CHECK(strncmp(screenLine(0), "IFSPresente ", 12) == 0);
+}
+
+static void testPing() {
+	shimMillis = 1234;
+	CHECK_STR(command("<100|0|0>"), "<001|1234|1.0>");
+}
+
+/*****************************************************************************/
+/* parseMessage() separa os três campos sem copiar a mensagem.               */
+/*****************************************************************************/
+static void testParseMessage() {
+	strcpy(usbProto.receivedChars, "500|Fulano|5000");
+	parseMessage();
+	CHECK(netMessage.code == 500);
+	CHECK(netMessage.TTL == 5000);
+	CHECK_STR(netMessage.message, "Fulano");
+	CHECK(netMessage.messageSize == 6);
+	CHECK(netMessage.message == usbProto.receivedChars + 4);
+
+	strcpy(usbProto.receivedChars, "500|Fulano");
+	parseMessage();
+	CHECK(netMessage.code == 0);
+
+	// Código só com dígitos, até 999
+	static const char *const badCodes[] = {"1a0|x|0", "50 0|x|0", "-500|x|0", "1000|x|0", "65536500|x|0"};
+	for (byte i = 0; i < sizeof(badCodes) / sizeof(badCodes[0]); i++) {
+		strcpy(usbProto.receivedChars, badCodes[i]);
+		parseMessage();
+		CHECK(netMessage.code == 0);
+	}
+	strcpy(usbProto.receivedChars, "0999|x|0");
+	parseMessage();
+	CHECK(netMessage.code == 999);
+	CHECK_STR(command("<1a00|x|0>"), "");    // Seria o PING
+}
+
+/*****************************************************************************/
+/* TTL acima de 32767 fica em 32767, como no modo binário, sem dar a volta.  */
+/*****************************************************************************/
+static void testTtlSaturation() {
+	strcpy(usbProto.receivedChars, "500|x|32767");
+	parseMessage();
+	CHECK(netMessage.TTL == 32767);
+	strcpy(usbProto.receivedChars, "500|x|40000");
+	parseMessage();
+	CHECK(netMessage.TTL == 32767);
+	strcpy(usbProto.receivedChars, "500|x|99999999999999999999");
+	parseMessage();
+	CHECK(netMessage.TTL == 32767);
+}
+
+/*****************************************************************************/
+/* Uma linha recebida vai para a tela e volta à mensagem padrão no fim do    */
+/* TTL.                                                                      */
+/*****************************************************************************/
+static void testLineTtl() {
+	shimMillis = 10000;
+	CHECK_STR(command("<300|Palestra|1000>"), "<002|OK|>");
+	CHECK(strncmp(screenLine(1), "Palestra ", 9) == 0);
+	shimMillis = 10999;
+	atualizaDisplay(-1);
+	CHECK(strncmp(screenLine(1), "Palestra ", 9) == 0);
+	shimMillis = 11001;
+	atualizaDisplay(-1);
+	CHECK(strncmp(screenLine(1), "Local Disponivel", 16) == 0);
+}
+
+/*****************************************************************************/
+/* GETTIME responde da hora em RAM, acertada por SETTIME e avançada pelo     */
+/* millis() sem pulsos do SQW.                                               */
+/*****************************************************************************/
+static void testGetTime() {
+	shimMillis = 20000;
+	CHECK_STR(command("<700|2024:05:17:08:30:00|0>"), "<002|OK|>");
+	shimMillis = 22500;
+	CHECK_STR(command("<701|0|0>"), "<003|2024:05:17:08:30:02|0.00>");
+}
+
+/*****************************************************************************/
+/* HEALTH página 3: taxas e erros do barramento I2C e cargas da CGRAM.       */
+/*****************************************************************************/
+static void testHealthI2c() {
+	unsigned int errors = i2c.errors;
+	unsigned int uploads = glyphs.uploads;
+	i2c.errors = 2;
+	glyphs.uploads = 5;
+	const char *reply = command("<102|3|0>");
+	CHECK(strncmp(reply, "<007|3|", 7) == 0);
+	CHECK(strcmp(reply + strlen(reply) - 5, ":2:5>") == 0);
+	i2c.errors = errors;
+	glyphs.uploads = uploads;
+}
+
+/*****************************************************************************/
+/* HEALTH: uma página por pedido, com os campos na ordem de formataSaude(),  */
+/* e dados vazios depois da última.                                          */
+/*****************************************************************************/
+static void testHealthReply() {
+	SerialProtocol::Counters c;
+	unsigned long field[4];
+	usbProto.snapshot(c);
+	const char *reply = command("<102|0|0>");
+	CHECK(sscanf(reply, "<007|0|%lu:%lu:%lu>", &field[0], &field[1], &field[2]) == 3);
+	CHECK(field[0] == c.framesReceived + 1);    // O próprio HEALTH
+	CHECK(field[1] == c.framesSent);
+	CHECK(field[2] == c.discardedBytes);
+
+	Serial.feed("xy");                          // Fora de quadro
+	CHECK_STR(command("<102|1|0>"), "<007|1|0:0:0:0>");
+	reply = command("<102|0|0>");
+	CHECK(sscanf(reply, "<007|0|%lu:%lu:%lu>", &field[0], &field[1], &field[2]) == 3);
+	CHECK(field[0] == c.framesReceived + 3);
+	CHECK(field[1] == c.framesSent + 2);
+	CHECK(field[2] == c.discardedBytes + 2);
+
+	health.loopsPerSecond = 1234;
+	reply = command("<102|2|0>");
+	CHECK(sscanf(reply, "<007|2|%lu:%lu:%lu:%lu>", &field[0], &field[1], &field[2], &field[3]) == 4);
+	CHECK(field[0] == 1234);
+	unsigned long longest = 0;
+	for (byte i = 0; i < NUM_TASKS; i++)
+		longest = max(longest, tasks.longest[i]);
+	CHECK(field[1] == longest);
+	CHECK(field[2] == Health::stackHeadroom());
+	CHECK(field[3] == Health::freeRam());
+	CHECK(field[2] > 0 && field[2] <= field[3] && field[3] < SHIM_FREE_RAM);
+
+	CHECK_STR(command("<102|4|0>"), "<007|4|>");
+	CHECK_STR(command("<102|255|0>"), "<007|255|>");
+}
+
+/*****************************************************************************/
+/* Uma rajada é tratada numa só passada, com uma resposta por quadro.        */
+/*****************************************************************************/
+static void testBurst() {
+	CHECK_STR(command("<500|Ana|0><600|0|0><601|0|0>"), "<002|OK|><002|OK|><002|OK|>");
+	CHECK(!usbProto.inputPending());
+}
+
+/*****************************************************************************/
+/* Só um quadro recebido depois da troca confirma a taxa: o que já estava na */
+/* fila, na taxa antiga, é descartado.                                       */
+/*****************************************************************************/
+static void testBaudConfirmation() {
+	shimMillis = 20000;
+	CHECK_STR(command("<800|115200|500><100|0|0>"), "<004|115200|>");
+	CHECK(Serial.baud == 115200);
+	shimMillis = 20501;
+	CHECK_STR(command(""), "");
+	CHECK(Serial.baud == DEFAULT_BAUD_RATE);
+
+	shimMillis = 30000;
+	command("<800|115200|500>");
+	shimMillis = 30100;
+	CHECK_STR(command("<100|0|0>"), "<001|30100|1.0>");
+	shimMillis = 31000;
+	command("");
+	CHECK(Serial.baud == 115200);
+	CHECK_STR(command("<800|9600|0>"), "<004|9600|>");
+	CHECK(Serial.baud == DEFAULT_BAUD_RATE);
+}
+
+/*****************************************************************************/
+/* SCROLL só confirma o que aplicou: campos faltando ou linha inexistente    */
+/* recebem 008 e não mudam a rolagem.                                        */
+/*****************************************************************************/
+static void testScrollReply() {
+	CHECK_STR(command("<900|1:250:1000:2000:1|0>"), "<002|OK|>");
+	CHECK(dispArray[1].stepDelay == 250);
+	CHECK(dispArray[1].scrollMode == 1);
+	CHECK_STR(command("<900|9:100:0:0:0|0>"), "<008|900|>");
+	CHECK_STR(command("<900|1:100|0>"), "<008|900|>");
+	CHECK_STR(command("<900|1:100:0:0:0:7|0>"), "<008|900|>");
+	CHECK_STR(command("<900|1::0:0:0|0>"), "<008|900|>");
+	CHECK_STR(command("<900|1:1x0:0:0:0|0>"), "<008|900|>");
+	CHECK_STR(command("<900|1:-1:0:0:0|0>"), "<008|900|>");
+	CHECK_STR(command("<900|1:100:65536:0:0|0>"), "<008|900|>");
+	CHECK_STR(command("<900|1:100:0:0:3|0>"), "<008|900|>");
+	CHECK_STR(command("<900|1:100:0:0:8|0>"), "<008|900|>");
+	CHECK(dispArray[1].stepDelay == 250);
+	CHECK(dispArray[1].scrollMode == 1);
+
+	// Passo limitado para o dobro, com SCROLL_EASE, caber em 16 bits
+	CHECK_STR(command("<900|1:65535:0:65535:6|0>"), "<002|OK|>");
+	CHECK(dispArray[1].stepDelay == SCROLL_MAX_STEP_DELAY);
+	CHECK(dispArray[1].pauseEnd == 65535);
+	CHECK(dispArray[1].scrollMode == (SCROLL_MARQUEE | SCROLL_EASE));
+	CHECK_STR(command("<900|1:0:0:0:0|0>"), "<002|OK|>");
+	CHECK(dispArray[1].stepDelay == 1);
+	CHECK_STR(command("<900|1:250:1000:2000:1|0>"), "<002|OK|>");
+}
+
+/*****************************************************************************/
+/* SCREEN só confirma quadros aplicados; um registro inválido recusa todos.  */
+/*****************************************************************************/
+static void testScreenReply() {
+	shimMillis = 40000;
+	CHECK_STR(command("<210|1\x1F" "0\x1F" "Aula\x1E" "2\x1F" "0\x1F" "Prof|0>"), "<002|OK|>");
+	CHECK(strncmp(screenLine(1), "Aula ", 5) == 0);
+	CHECK(strncmp(screenLine(2), "Prof ", 5) == 0);
+	CHECK_STR(command("<210|1\x1F" "0\x1F" "Outra\x1E" "9\x1F" "0\x1F" "X|0>"), "<008|210|>");
+	CHECK_STR(command("<210|1\x1F" "Outra|0>"), "<008|210|>");
+	CHECK_STR(command("<210||0>"), "<008|210|>");
+	CHECK_STR(command("<210|1\x1F" "\x1F" "Outra|0>"), "<008|210|>");
+	CHECK_STR(command("<210|1\x1F" "5s\x1F" "Outra|0>"), "<008|210|>");
+	CHECK_STR(command("<210|1\x1F" "-1\x1F" "Outra|0>"), "<008|210|>");
+	CHECK_STR(command("<210|1\x1F" "32768\x1F" "Outra|0>"), "<008|210|>");
+	CHECK_STR(command("<210|1\x1F" "4294967297\x1F" "Outra|0>"), "<008|210|>");
+	CHECK_STR(command("<210| 1\x1F" "0\x1F" "Outra|0>"), "<008|210|>");
+	atualizaDisplay(-1);
+	CHECK(strncmp(screenLine(1), "Aula ", 5) == 0);
+
+	// O maior TIMEOUT aceito
+	CHECK_STR(command("<210|1\x1F" "32767\x1F" "Longa|0>"), "<002|OK|>");
+	CHECK(dispArray[1].TTL == 40000UL + 32767);
+}
+
+/*****************************************************************************/
+/* BEEP_PATTERN e BEEP_PLAY recusam padrões inválidos e posições vazias.     */
+/*****************************************************************************/
+static void testBeepReply() {
+	CHECK_STR(command("<602|0:1000:100:50:2000:100:0|0>"), "<002|OK|>");
+	CHECK(buzzer.slotSize[0] == 2);
+	CHECK_STR(command("<602|0:1000:100|0>"), "<008|602|>");
+	CHECK_STR(command("<602|9:1000:100:50|0>"), "<008|602|>");
+	CHECK_STR(command("<602|0:1:1:1:2:2:2:3:3:3:4:4:4:5:5:5|0>"), "<008|602|>");
+	CHECK_STR(command("<602|256:1000:100:50|0>"), "<008|602|>");    // Não vira a posição 0
+	CHECK_STR(command("<602|0:66536:100:50|0>"), "<008|602|>");     // Nem 1000 Hz
+	CHECK_STR(command("<602|0:-1:100:50|0>"), "<008|602|>");
+	CHECK_STR(command("<602|0::100:50|0>"), "<008|602|>");
+	CHECK_STR(command("<602|0:1000:100:50 |0>"), "<008|602|>");
+	CHECK(buzzer.slotSize[0] == 2);
+	CHECK(buzzer.slots[0][0].frequency == 1000);
+
+	// Um padrão em PROGMEM no mesmo endereço de slots[0] continua tocando
+	buzzer.play(buzzer.slots[0], 1);
+	CHECK_STR(command("<602|0:1000:100:50|0>"), "<002|OK|>");
+	CHECK(buzzer.step() != 0);
+	buzzer.stop();
+	// O próprio slots[0] tocando para antes de ser regravado
+	buzzer.playSlot(0);
+	CHECK_STR(command("<602|0:1000:100:50:2000:100:0|0>"), "<002|OK|>");
+	CHECK(buzzer.step() == 0);
+
+	unsigned long tones = shimTone.calls;
+	CHECK_STR(command("<603|0|0>"), "<002|OK|>");
+	while (tasks.run())
+		;
+	CHECK(shimTone.calls > tones);
+	CHECK_STR(command("<603|1|0>"), "<008|603|>");
+	CHECK_STR(command("<603|9|0>"), "<008|603|>");
+}
+
+int main() {
+	setup();
+	while (tasks.run())  // Tarefas acordadas no setup(): a tela ganha as mensagens padrão
+		;
+	testSetup();
+	testPing();
+	testParseMessage();
+	testTtlSaturation();
+	testLineTtl();
+	testGetTime();
+	testHealthReply();
+	testHealthI2c();
+	testBurst();
+	testBaudConfirmation();
+	testScrollReply();
+	testScreenReply();
+	testBeepReply();
+	return CHECK_RESULT();
+}
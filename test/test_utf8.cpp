@@ -0,0 +1,74 @@
+#include <Arduino.h>
+#include "utf8.h"
+#include "check.h"
+
+/*****************************************************************************/
+/* Converte no lugar e confere que o decodificador byte a byte dá o mesmo.   */
+/*****************************************************************************/
+static const char *convert(const char *text) {
+	static char str[64];
+	byte size = strlen(text);
+	strcpy(str, text);
+	byte n = utf8ToWin1252(str, size);
+
+	char incremental[64];
+	byte m = 0;
+	Utf8Decoder utf8;
+	for (byte i = 0; i < size; i++)
+		m += utf8.decode(text[i], incremental + m);
+	if (utf8.incomplete())
+		incremental[m++] = UTF8_REPLACEMENT;
+	CHECK(m == n && memcmp(incremental, str, n) == 0);
+	return str;
+}
+
+static void testValid() {
+	CHECK_STR(convert("Sala 1"), "Sala 1");
+	CHECK_STR(convert("Jo\xC3\xA3o"), "Jo\xE3o");                  // ã
+	CHECK_STR(convert("\xE2\x80\x93 \xE2\x82\xAC"), "\x96 \x80");   // – €
+	CHECK_STR(convert("\xED\x9F\xBF"), "?");                       // U+D7FF
+	CHECK_STR(convert("\xEF\xBF\xBF"), "?");                       // U+FFFF
+	CHECK_STR(convert("\xF0\x90\x80\x80|"), "?|");                 // U+10000
+	CHECK_STR(convert("\xF4\x8F\xBF\xBF"), "?");                   // U+10FFFF
+}
+
+/*****************************************************************************/
+/* Formas longas não podem virar os delimitadores '<', '|' e '>'.            */
+/*****************************************************************************/
+static void testOverlong() {
+	CHECK_STR(convert("\xC0\xBC"), "??");
+	CHECK_STR(convert("\xC1\xBE"), "??");
+	CHECK_STR(convert("\xE0\x81\xBC"), "???");
+	CHECK_STR(convert("\xE0\x9F\xBF"), "???");
+	CHECK_STR(convert("\xF0\x80\x80\xBC"), "????");
+	CHECK_STR(convert("\xF0\x8F\xBF\xBF"), "????");
+}
+
+static void testSurrogates() {
+	CHECK_STR(convert("\xED\xA0\x80"), "???");
+	CHECK_STR(convert("\xED\xBF\xBFx"), "???x");
+}
+
+static void testAboveMax() {
+	CHECK_STR(convert("\xF4\x90\x80\x80"), "????");
+	CHECK_STR(convert("\xF5\x80\x80\x80"), "????");
+}
+
+/*****************************************************************************/
+/* Sequências interrompidas e truncadas.                                     */
+/*****************************************************************************/
+static void testInterrupted() {
+	CHECK_STR(convert("\xC3|"), "?|");
+	CHECK_STR(convert("\xE2\x80<"), "?<");
+	CHECK_STR(convert("\xE2\x80"), "?");
+	CHECK_STR(convert("\x80"), "?");
+}
+
+int main() {
+	testValid();
+	testOverlong();
+	testSurrogates();
+	testAboveMax();
+	testInterrupted();
+	return CHECK_RESULT();
+}